@@ -0,0 +1,169 @@
+#ifndef ASYNCWRITER_HPP
+#define ASYNCWRITER_HPP
+
+#include "Common.hpp"
+#include "CurlSession.hpp"
+#include "GzipCompressor.hpp"
+#include "CircuitBreaker.hpp"
+#include "Scheduler.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <unordered_set>
+
+// Asynchronous InfluxDB v2 write engine on the curl multi interface. One background thread
+// keeps up to maxInFlight POSTs on the wire (keep-alive handles attached to the shared
+// CurlSession caches) while callers go on encoding the next batch.
+//
+// Real-time and backfill bodies wait in queues of their own: a free handle always goes to a
+// real-time body first, and a full backfill queue never holds up a real-time submit. Backfill
+// bodies take at most the scheduler's backfill share of the requests in flight (at least
+// one), so real-time bodies find a free handle during a backfill.
+//
+// Every body carries the sensor ids it contains and the origin that submitted it. A body is
+// never sent while an earlier body of its class and origin with one of the same ids is still
+// queued or in flight, so the points each origin writes for a sensor reach the server in
+// submission order; bodies of other origins do not hold it back. Failed bodies are retried in order; with a
+// breaker, nothing is started while it holds calls back, and every attempt reports to it.
+//
+// Refused lines never cost a full resend: lines the server names go to the RejectLog and
+// only the others are sent again. When it names none, the body is bisected until the bad
+// lines are isolated; halves that were accepted are not sent again. Until some part of such
+// a body gets through, only one part is bisected further: if it is refused down to a single
+// line with the body's own error, the error is about the request (bucket, precision, schema)
+// rather than its lines, and the body fails as a whole instead of being quarantined line by
+// line. Bisection also stops after MAX_BISECT_DEPTH splits.
+class AsyncWriter {
+public:
+    // Called on the writer thread after every attempt with its latency and whether the
+    // server was healthy (refused lines still count as healthy)
+    using Observer = std::function<void(std::chrono::milliseconds latency, bool ok)>;
+
+    // Called on the writer thread once a body is done; error is empty when every line was
+    // accepted or quarantined
+    using Callback = std::function<void(const std::string& error)>;
+
+    // Constructors and destructors (gzip_level > 0 compresses the parts of split bodies)
+    AsyncWriter(const std::string& url, const std::string& token, const std::string& bucket,
+                int max_in_flight, int gzip_level = 0, CircuitBreaker* breaker = nullptr,
+                Observer observer = nullptr);
+    ~AsyncWriter(); // Waits for every submitted body
+
+    // Owns a thread and curl handles, so copies are not allowed
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    // Queue newline-terminated lines for sending, as gzipped_body when that is not empty (the
+    // lines are then dropped and only inflated again if the server refuses the body); blocks
+    // while the queue of priority is full. done gets the last error after attempts
+    // failed tries.
+    void submit(std::string lines, std::string gzipped_body, std::vector<int> sensor_ids,
+                std::uint64_t origin, int attempts, Priority priority, Callback done);
+
+    // Resolve promise with the outcome passed to a Callback
+    static void settle(std::promise<void>& promise, const std::string& error);
+
+    // Getters
+    int maxInFlight() const { return maxInFlight_; }
+
+    static constexpr int DEFAULT_MAX_IN_FLIGHT = 4;
+
+private:
+    // Shared by a submitted body and the parts it is split into
+    struct Completion {
+        Callback done;
+        std::size_t outstanding = 1;
+        std::string error;
+    };
+
+    struct Probe;
+
+    struct Request {
+        std::uint64_t seq;
+        std::string lines;                   // Empty while gzipped holds the body
+        std::string gzipped;                 // Sent instead of lines when not empty
+        std::unique_ptr<RequestBody> source; // Streams the body that is sent
+        std::vector<int> sensorIds;
+        std::uint64_t origin;
+        Priority priority;
+        int attemptsLeft;
+        std::chrono::steady_clock::time_point notBefore;
+        std::chrono::steady_clock::time_point startedAt;
+        std::string response;
+        std::shared_ptr<Completion> completion;
+        int bisectDepth = 0;
+        std::shared_ptr<Probe> probe; // Set on the parts of a body still suspected as a whole
+    };
+
+    // A body refused without naming lines, while none of its parts got through. The parts
+    // refused with its error wait in parked until the parts in flight are resolved.
+    struct Probe {
+        std::string message;
+        std::vector<std::unique_ptr<Request>> parked;
+        int inFlight = 0;
+        bool resolved = false; // A part got through or failed otherwise: plain bisection from now on
+    };
+
+    void run();
+
+    // Key of a sensor of an origin in the ordering of bodies
+    static std::uint64_t orderKey(std::uint64_t origin, int sensor_id) {
+        return (origin << 32) | static_cast<std::uint32_t>(sensor_id);
+    }
+
+    // Move every queued body that may go now onto a free handle; caller holds the mutex
+    void dispatch();
+    void start(std::unique_ptr<Request> request);
+
+    // Resolve a completed transfer, or queue it (or its parts) again
+    void finish(CURL* handle, CURLcode result);
+
+    // Bisect a body refused as a whole, or quarantine it once it cannot be split further;
+    // the parts of a probed body fail with it instead of being quarantined
+    void split(std::unique_ptr<Request> request, const std::string& message, std::shared_ptr<Probe> probe);
+
+    // A part of a probed body was resolved on its own, so the parked parts are bisected after all
+    void release(Probe& probe);
+
+    // Replace the lines of a request that is split or trimmed
+    void setLines(Request& request, std::string lines);
+
+    // Bring back the plain lines of a gzipped request, to find refused lines or split it
+    static void restoreLines(Request& request);
+
+    // Put a request back at its place in the queue
+    void requeue(std::unique_ptr<Request> request, std::chrono::steady_clock::duration delay);
+
+    // One part of a body is done; the callback runs when all parts are
+    static void complete(Request& request, const std::string& error = "");
+
+    static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* s);
+
+    std::string url;
+    std::string bucket;
+    CurlHeaders plainHeaders;
+    CurlHeaders gzipHeaders;
+    const int maxInFlight_;
+    const std::size_t maxQueued;
+    std::unique_ptr<GzipCompressor> gzip;
+    CircuitBreaker* breaker;
+    Observer observer;
+
+    CURLM* multi;
+    std::vector<CURL*> idleHandles;
+    std::unordered_map<CURL*, std::unique_ptr<Request>> active;
+
+    std::mutex mutex;
+    std::condition_variable queueSpace;
+    std::deque<std::unique_ptr<Request>> pending[PRIORITY_CLASSES]; // In seq order, one per class
+    std::uint64_t nextSeq = 0;
+    bool stopping = false;
+    std::thread worker;
+
+    static constexpr std::chrono::seconds RETRY_PAUSE{1}; // Without a breaker
+    static constexpr int MAX_BISECT_DEPTH = 16;           // Parts of at least 1/65536 of a body
+};
+
+#endif // ASYNCWRITER_HPP
@@ -16,7 +16,7 @@ public:
     bool connect(const std::string& connectionString);
     void closeConnection();
     bool queryExecute(const std::string& query, bool display = true);
-    bool copyToSQL(const std::string& tableName, EpitrendBinaryData data);
+    bool copyToSQL(const std::string& tableName, const EpitrendBinaryData& data);
 
     static bool queryDatabase(const std::string& connectionString, const std::string& query, bool display = true);
 
@@ -0,0 +1,73 @@
+#ifndef BATCHER_HPP
+#define BATCHER_HPP
+
+#include "Common.hpp"
+
+#include <atomic>
+#include <mutex>
+
+// When to close a batch; a zero limit is not checked
+struct BatchPolicy {
+    std::size_t maxLines = 5000;
+    std::size_t maxBytes = 0;
+    std::chrono::milliseconds maxLinger{0}; // Since the first line of the batch
+
+    // Adaptive mode scales both limits between minScale and maxScale: up while writes are
+    // quicker than targetLatency, down when they are slow, halved on errors
+    bool adaptive = false;
+    std::chrono::milliseconds targetLatency{1000};
+    double minScale = 0.1;
+    double maxScale = 4.0;
+
+    // Big bodies for throughput
+    static BatchPolicy backfill();
+    // Small, quick bodies for freshness
+    static BatchPolicy realTime();
+    // Merged bodies of the shared sink: whatever queued up while the writer was busy
+    static BatchPolicy coalesce();
+};
+
+// Accumulation rule shared by everything that batches: callers report the size of the open
+// batch after each append and hand it over when full() says so. Write outcomes may be
+// recorded from another thread.
+class Batcher {
+public:
+    // Constructors
+    explicit Batcher(const BatchPolicy& policy = BatchPolicy());
+
+    // Whether a batch of lines lines and bytes bytes should be closed now
+    bool full(std::size_t lines, std::size_t bytes);
+
+    // Same check on the size limits alone, without the linger; safe from any thread
+    bool overLimit(std::size_t lines, std::size_t bytes) const;
+
+    // The open batch was handed over; the linger clock restarts at the next line
+    void flushed() { open = false; }
+
+    // Outcome of one write, for the adaptive mode
+    void record(std::chrono::milliseconds latency, bool ok);
+
+    // Setters
+    void setPolicy(const BatchPolicy& policy);
+
+    // Getters
+    const BatchPolicy& policy() const { return policy_; }
+    std::size_t lineLimit() const { return lineLimit_; }
+    std::size_t byteLimit() const { return byteLimit_; }
+
+private:
+    // Caller holds the mutex
+    void applyScale();
+
+    BatchPolicy policy_;
+    std::atomic<std::size_t> lineLimit_;
+    std::atomic<std::size_t> byteLimit_;
+
+    bool open = false;
+    std::chrono::steady_clock::time_point openedAt;
+
+    std::mutex mutex;
+    double scale = 1.0;
+};
+
+#endif // BATCHER_HPP
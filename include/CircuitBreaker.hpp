@@ -0,0 +1,64 @@
+#ifndef CIRCUITBREAKER_HPP
+#define CIRCUITBREAKER_HPP
+
+#include "Common.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <random>
+
+// When to stop calling a failing sink and how long to wait between tries
+struct BreakerPolicy {
+    int failureThreshold = 5;                 // Consecutive failures that open the circuit
+    std::chrono::milliseconds baseDelay{500}; // Pause after the first failure, doubled after each
+    std::chrono::milliseconds maxDelay{60000};
+};
+
+// Health of one sink (an InfluxDB server), shared by every thread and writer that calls it.
+// Failed calls space the next ones out exponentially, with jitter so callers do not retry
+// in step. After failureThreshold failures in a row the circuit opens: nobody calls the sink
+// until the delay has passed, then a single caller is let through as a probe. A success
+// from any caller closes the circuit again.
+class CircuitBreaker {
+public:
+    enum class State { Closed, Open, HalfOpen };
+
+    // The breaker of a sink, created on first use; sink is any stable name such as host:port
+    static CircuitBreaker& forSink(const std::string& sink);
+
+    // Whether a call may be made now; in the open state the first caller after the delay
+    // gets the probe and the others keep waiting
+    bool allow();
+
+    // Block until allow() says yes
+    void wait();
+
+    // Outcome of a call; only server and transport errors count as failures
+    void record(bool ok);
+
+    // Setters
+    void setPolicy(const BreakerPolicy& policy);
+
+    // Getters
+    const std::string& sink() const { return sink_; }
+    State state() const;
+    std::chrono::steady_clock::time_point retryAt() const;
+
+private:
+    explicit CircuitBreaker(const std::string& sink);
+
+    // Caller holds the mutex
+    std::chrono::milliseconds backoff();
+
+    std::string sink_;
+    BreakerPolicy policy_;
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    State state_ = State::Closed;
+    int failures = 0;
+    std::chrono::steady_clock::time_point retryAt_;
+    std::minstd_rand jitter;
+};
+
+#endif // CIRCUITBREAKER_HPP
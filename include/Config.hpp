@@ -7,6 +7,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <iostream>
+#include <vector>
 
 class Config {
 public:
@@ -26,9 +27,35 @@ public:
     std::string getPrecision() const;
     std::string getToken() const;
 
+    // Optional keys, with defaults when absent
+    std::string getSensorRegistryFile() const;
+    std::string getRejectFile() const;
+    std::string getEpitrendIndexFile() const;
+    std::string getRGAIndexFile() const;
+    std::string getLedgerFile() const;
+    std::string getSpoolDir() const;
+    bool getInfluxSpool() const;
+    int getInfluxGzipLevel() const;
+    int getInfluxMaxInFlight() const;
+    int getSchedulerWorkers() const;
+    double getBackfillShare() const;
+    int getBackfillWorkers() const;
+    int getBackfillQueueDepth() const;
+    int getEncoderWorkers() const;
+    int getSenderWorkers() const;
+    int getPipelineQueueDepth() const;
+    int getReadAheadThreads() const;
+    int getReadAheadFiles() const;
+
+    // Any optional key, or default_value when it is absent or empty
+    std::string getValueOr(const std::string& key, const std::string& default_value) const;
+
 private:
     void loadConfig(const std::string& configFilePath);
 
+    // Create the directories of the output files and the spool; throws when one cannot be made
+    void prepareOutputPaths() const;
+
     std::unordered_map<std::string, std::string> configMap;
 };
 
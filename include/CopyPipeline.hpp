@@ -0,0 +1,201 @@
+#ifndef COPYPIPELINE_HPP
+#define COPYPIPELINE_HPP
+
+#include "Common.hpp"
+#include "BoundedQueue.hpp"
+#include "InfluxDatabase.hpp"
+#include "Scheduler.hpp"
+
+#include <atomic>
+#include <mutex>
+
+// Encode and send stages of a backfill copy behind its reader stage. Blocks of parsed data
+// are turned into line-protocol batches by the encoder threads while the sender threads ship
+// the batches of earlier blocks, so the share, the CPU and the network are busy at the same
+// time. The stages are connected by bounded queues: a stage that falls behind holds back the
+// one before it, which bounds memory and makes throughput that of the slowest stage.
+template <typename Data>
+class CopyPipeline {
+public:
+    // Both stages retry a failed block up to max_tries times, spaced by the server's breaker
+    // and a short pause
+    CopyPipeline(InfluxDatabase& influx_db, int encoders, int senders, std::size_t queue_depth, int max_tries = 100)
+        : influxDb(influx_db), maxTries(max_tries), blocks(queue_depth), encoded(queue_depth) {
+        if (encoders < 1 || senders < 1) {
+            throw std::invalid_argument("Error in CopyPipeline::CopyPipeline call: need at least one encoder and one sender, got " +
+                std::to_string(encoders) + " and " + std::to_string(senders));
+        }
+        // The threads already running are joined when a later one cannot be started
+        try {
+            for (int i = 0; i < encoders; ++i) {
+                encoderThreads.emplace_back([this] { encode(); });
+            }
+            for (int i = 0; i < senders; ++i) {
+                senderThreads.emplace_back([this] { send(); });
+            }
+        } catch (...) {
+            cancelled = true;
+            join();
+            throw;
+        }
+    }
+
+    // Drops the blocks not sent yet unless finish() was called
+    ~CopyPipeline() {
+        cancelled = true;
+        join();
+    }
+
+    CopyPipeline(const CopyPipeline&) = delete;
+    CopyPipeline& operator=(const CopyPipeline&) = delete;
+
+    // Hand over a block of parsed data, waiting while the encoders are behind; on_sent runs on
+    // a sender thread once the server accepted every batch of the block. Throws once a stage
+    // gave up on a block.
+    void submit(Data data, std::function<void()> on_sent) {
+        if (!cancelled && blocks.push(Block{std::move(data), std::move(on_sent)})) {
+            return;
+        }
+        rethrow();
+        throw std::runtime_error("Error in CopyPipeline::submit call: pipeline already finished");
+    }
+
+    // Wait until every block was sent; rethrows the first failure of a stage
+    void finish() {
+        join();
+        rethrow();
+    }
+
+    // Getters
+    std::size_t sentPoints() const { return sent; }
+
+private:
+    struct Block {
+        Data data;
+        std::function<void()> onSent;
+    };
+
+    struct EncodedBlock {
+        Data data; // Kept until sent, to encode the batches of a failed send again
+        std::vector<InfluxDatabase::EncodedBatch> batches;
+        std::function<void()> onSent;
+        std::size_t points = 0;
+    };
+
+    void encode() {
+        Block block;
+        while (blocks.pop(block)) {
+            if (cancelled) {
+                continue;
+            }
+            try {
+                // Encoding gives way to real-time polls like the reads do
+                Scheduler::instance().yieldToRealTime();
+                EncodedBlock out;
+                out.points = block.data.getSampleCount();
+                retry("CopyPipeline::encode", [&] { out.batches = influxDb.encodeBatches(block.data); });
+                out.onSent = std::move(block.onSent);
+                out.data = std::move(block.data);
+                encoded.push(std::move(out));
+            } catch (...) {
+                fail(std::current_exception());
+            }
+        }
+    }
+
+    void send() {
+        EncodedBlock block;
+        while (encoded.pop(block)) {
+            if (cancelled) {
+                continue;
+            }
+            try {
+                // The senders wait on the server rather than the CPU, so they run off the pool: the
+                // writers of the sink hold backfill to its share of the requests in flight, and a
+                // scheduler job per block would let only its backfill slots send at once. A failed
+                // send leaves only the batches the server did not accept for the retry.
+                retry("CopyPipeline::send", [&] {
+                    // The lines of batches that failed before went to the sink; encode them again
+                    for (auto& batch : block.batches) {
+                        influxDb.encodeAgain(block.data, batch);
+                    }
+                    Scheduler::instance().yieldToRealTime();
+                    influxDb.sendBatches(block.batches);
+                });
+                sent += block.points;
+                if (block.onSent) {
+                    block.onSent();
+                }
+            } catch (...) {
+                fail(std::current_exception());
+            }
+        }
+    }
+
+    template <typename Attempt>
+    void retry(const std::string& caller, Attempt attempt) {
+        for (int tries = 1; ; ++tries) {
+            // Returns at once while the server is healthy, else when the shared backoff allows a try
+            influxDb.breaker().wait();
+            try {
+                attempt();
+                return;
+            } catch (const std::exception& e) {
+                if (tries >= maxTries || cancelled) {
+                    throw std::runtime_error("Error in " + caller + " call: gave up after " + std::to_string(tries) + " tries: " + e.what());
+                }
+                std::cerr << "Warning in " << caller << " call: " << e.what() << "\n Retrying...\n";
+                // Transport and server errors were counted with the breaker by the writer
+                std::this_thread::sleep_for(RETRY_PAUSE);
+            }
+        }
+    }
+
+    // Stop both stages; the blocks still queued are dropped
+    void fail(std::exception_ptr failure) {
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = failure;
+            }
+        }
+        cancelled = true;
+        blocks.close();
+        encoded.close();
+    }
+
+    // The senders stop only after the last encoder, so no encoded block is lost
+    void join() {
+        blocks.close();
+        for (auto& thread : encoderThreads) {
+            if (thread.joinable()) thread.join();
+        }
+        encoded.close();
+        for (auto& thread : senderThreads) {
+            if (thread.joinable()) thread.join();
+        }
+    }
+
+    void rethrow() {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    InfluxDatabase& influxDb;
+    const int maxTries;
+    BoundedQueue<Block> blocks;
+    BoundedQueue<EncodedBlock> encoded;
+    std::vector<std::thread> encoderThreads;
+    std::vector<std::thread> senderThreads;
+    std::atomic<bool> cancelled{false};
+    std::atomic<std::size_t> sent{0};
+
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    static constexpr std::chrono::seconds RETRY_PAUSE{1}; // On top of the breaker's backoff
+};
+
+#endif // COPYPIPELINE_HPP
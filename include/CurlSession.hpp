@@ -0,0 +1,67 @@
+#ifndef CURLSESSION_HPP
+#define CURLSESSION_HPP
+
+#include "Common.hpp"
+#include "RequestBody.hpp"
+#include "CircuitBreaker.hpp"
+
+#include <curl/curl.h>
+
+// Helper class to properly handle curl headers and prevent memory allocation issues
+class CurlHeaders {
+public:
+    CurlHeaders() : headers_(nullptr) {}
+    ~CurlHeaders() { if (headers_) curl_slist_free_all(headers_); }
+    CurlHeaders(const CurlHeaders&) = delete;
+    CurlHeaders& operator=(const CurlHeaders&) = delete;
+    void append(const std::string& header);
+    struct curl_slist* get() const { return headers_; }
+
+private:
+    struct curl_slist* headers_;
+};
+
+// Long-lived keep-alive HTTP session: one curl easy handle per owner, reused for every
+// request so its connection stays open between calls. The DNS and TLS session caches are
+// shared process-wide through one curl share handle, so threads talking to the same
+// server reuse each other's lookups and resume each other's TLS sessions; connections
+// stay with the handle that opened them.
+class CurlSession {
+public:
+    // Constructors and destructors
+    CurlSession();
+    ~CurlSession();
+
+    // The easy handle is owned, so copies are not allowed
+    CurlSession(const CurlSession&) = delete;
+    CurlSession& operator=(const CurlSession&) = delete;
+
+    // POST body to url, streamed as curl sends it; the response body is appended to response.
+    // Returns the HTTP status code, throws on transport errors.
+    long post(const std::string& url, const CurlHeaders& headers,
+              RequestBody& body, std::string& response);
+    long post(const std::string& url, const CurlHeaders& headers,
+              const char* body, std::size_t length, std::string& response);
+
+    // GET url; the response body is appended to response. Returns the HTTP status code.
+    long get(const std::string& url, const CurlHeaders& headers, std::string& response);
+
+    // Report the outcome of every request to breaker (null for none)
+    void setBreaker(CircuitBreaker* breaker) { breaker_ = breaker; }
+
+    // Process-wide share handle for DNS and TLS session caches; attach it to any other
+    // easy handle that talks to the same servers
+    static CURLSH* share();
+
+private:
+    // Reset the per-request options, keeping the live connection
+    void prepare(const std::string& url, const CurlHeaders& headers, std::string& response);
+    long perform(const std::string& url);
+
+    static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* s);
+
+    CURL* handle;
+    CircuitBreaker* breaker_ = nullptr;
+};
+
+#endif // CURLSESSION_HPP
@@ -0,0 +1,52 @@
+#ifndef DELTATRACKER_HPP
+#define DELTATRACKER_HPP
+
+#include "Common.hpp"
+#include "EpitrendBinaryData.hpp"
+#include "RGAData.hpp"
+
+#include <limits>
+
+// Tracks, per series, the newest sample time that has been sent (its high-water mark).
+// delta() yields only the samples past the mark in O(new samples), with no snapshot
+// of earlier data kept around. An optional late window also lets through samples that
+// arrive up to late_window seconds behind the mark, unless that exact time was already sent.
+// Marks only move on commit(), so a failed send is simply retried on the next delta().
+class DeltaTracker {
+public:
+    // Constructors
+    explicit DeltaTracker(double late_window = 0.0);
+
+    // Append the samples of current that were not yet committed to out; returns their count
+    std::size_t delta(const EpitrendBinaryData& current, EpitrendBinaryData& out) const;
+    std::size_t delta(const RGAData& current, RGAData& out) const;
+
+    // Advance the marks past every sample of sent
+    void commit(const EpitrendBinaryData& sent);
+    void commit(const RGAData& sent);
+
+    // Utility Methods
+    double getLateWindow() const { return lateWindow; }
+    void clear();
+
+private:
+    struct Mark {
+        double highWater = -std::numeric_limits<double>::infinity();
+        std::vector<double> recent;  // Sorted sent times within the late window below highWater
+    };
+
+    // Index of the first sample of series that may be new, and whether every sample from it is new
+    std::size_t firstCandidate(const Mark* mark, const TimeSeries& samples, bool& all_new) const;
+
+    // Gather the new samples of series from first into times/values
+    void gatherNew(const Mark& mark, const TimeSeries& samples, std::size_t first,
+        std::vector<double>& times, std::vector<double>& values) const;
+
+    void advance(Mark& mark, const TimeSeries& samples);
+
+    double lateWindow = 0.0;
+    std::unordered_map<std::string, Mark> epitrendMarks;
+    std::unordered_map<RGAData::BinId, Mark> rgaMarks;
+};
+
+#endif // DELTATRACKER_HPP
@@ -2,37 +2,67 @@
 #define EPITRENDBINARYDATA_HPP
 
 #include "Common.hpp"
+#include "TimeSeries.hpp"
 
 class EpitrendBinaryData {
 public:
+    // Named columnar series for one sensor
+    struct Series {
+        std::string name;
+        TimeSeries samples;
+    };
+
     // Constructors
     EpitrendBinaryData() = default;
 
     // Setters
     void addDataItem(
-        std::string name, 
-        std::pair<double,double> time_series, 
+        const std::string& name,
+        std::pair<double,double> time_series,
+        bool verbose = false
+    );
+
+    // Bulk append of count time,value samples for one sensor
+    void appendRange(
+        const std::string& name,
+        const double* times,
+        const double* values,
+        std::size_t count,
+        bool verbose = false
+    );
+    void appendRange(
+        const std::string& name,
+        const std::vector<double>& times,
+        const std::vector<double>& values,
         bool verbose = false
     );
 
+    // Append every series of other, e.g. to merge files parsed on separate threads
+    void append(const EpitrendBinaryData& other, bool verbose = false);
+
+    // Remove the samples at or before time from every series, e.g. those already ingested
+    void dropThrough(double time);
+
     // Getters
-    std::unordered_map<std::string, std::unordered_map<double,double>> getAllTimeSeriesData();
-    int getByteSize();
+    const std::vector<Series>& getAllSeries() const;
+    const Series* findSeries(const std::string& name) const;
+    std::size_t getSampleCount() const;
+    int getByteSize() const;
 
     // Utility Methods
-    void printAllTimeSeriesData();
-    void printFileAllTimeSeriesData(const Config& config, const std::string& filename);
-    bool is_empty();
+    void printAllTimeSeriesData() const;
+    void printFileAllTimeSeriesData(const Config& config, const std::string& filename) const;
+    bool is_empty() const;
 
     // Clear all contents of time-series data
     void clear();
 
-    // Difference between two EpitrendBinaryData objects
-    EpitrendBinaryData difference(EpitrendBinaryData& other) const;
-
-
 private:
-    std::unordered_map<std::string, std::unordered_map<double,double>> allTimeSeriesData;
+    // Series are stored densely in first-seen order and looked up by name once per append
+    Series& seriesFor(const std::string& name);
+
+    std::vector<Series> allSeries;
+    std::unordered_map<std::string, std::size_t> seriesIndex;
     int byteSize = 0;
 };
 
@@ -20,6 +20,13 @@ public:
         }
     };
 
+    // One time,value sample as stored in the -binary.txt file
+    struct ValuePair {
+        float Time;
+        float Value;
+    };
+    static_assert(sizeof(ValuePair) == 2 * sizeof(float), "ValuePair must match the on-disk layout");
+
     // Constructors
     EpitrendBinaryFormat() = default;
 
@@ -34,6 +41,7 @@ public:
     int getTotalDataItems() const;
     double getTimeResolution() const;
     DataItem getDataItem(const std::string& name) const;
+    const std::unordered_map<std::string, DataItem>& getDataItems() const;
 
     // Utility Methods
     bool hasDataItem(const std::string& name) const;
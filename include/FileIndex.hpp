@@ -0,0 +1,66 @@
+#ifndef FILEINDEX_HPP
+#define FILEINDEX_HPP
+
+#include "Common.hpp"
+
+// One data file found on the share
+struct IndexedFile {
+    std::string GM;
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    int hour = 0; // 0 for daily RGA logs
+    std::string path;
+    std::uintmax_t size = 0;
+    std::int64_t mtime = 0;
+};
+
+// Index of the Epitrend or RGA files that exist below a server data directory, so backfill
+// only visits real files instead of probing every date. The tree is walked once and the index
+// is kept in index_path; a refresh lists again only the leaf directories (Epitrend months,
+// RGA days) whose mtime changed, as adding or removing a file changes it. Size and mtime of a
+// file are those of the last listing of its directory.
+class FileIndex {
+public:
+    enum class Layout {
+        Epitrend, // <root><GM> Molly/EpiTrend/EpiTrendData/<yyyy>/<mm>-<Mon>/<dd>day-<hh>hr-binary.txt
+        RGA       // <root><yyyy>-<mmm>-<dd>/daily log, <GM>, RGA MPH ..., ....dat
+    };
+
+    // Load the index an earlier run left in index_path, if any
+    FileIndex(Layout layout, const std::string& root, const std::string& index_path);
+
+    // Bring the index up to date with the tree and save it; returns the directories listed
+    std::size_t refresh(bool verbose = false);
+
+    // Getters
+    std::vector<IndexedFile> files() const; // Newest first, GMs in name order within a time
+    std::size_t size() const;
+
+private:
+    struct Directory {
+        std::int64_t mtime = 0;
+        std::vector<IndexedFile> files;
+    };
+
+    void load();
+    void save() const;
+
+    // Internal walk of each layout; leaf directories go through listLeaf
+    void walkEpitrend(std::map<std::string, Directory>& found, std::size_t& listed, bool verbose);
+    void walkRGA(std::map<std::string, Directory>& found, std::size_t& listed, bool verbose);
+
+    // Reuse the entry of an unchanged leaf directory, else list it with parse
+    void listLeaf(const std::filesystem::path& directory,
+                  const std::function<void(const std::filesystem::path&, Directory&)>& parse,
+                  std::map<std::string, Directory>& found, std::size_t& listed, bool verbose);
+
+    static std::int64_t mtimeOf(const std::filesystem::path& path);
+
+    Layout layout;
+    std::string root;
+    std::string indexPath;
+    std::map<std::string, Directory> directories; // By leaf directory path
+};
+
+#endif // FILEINDEX_HPP
@@ -0,0 +1,68 @@
+#ifndef FILELOADER_HPP
+#define FILELOADER_HPP
+
+#include "Common.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+// Read-ahead of the files a backfill is about to parse. Given the upcoming files in the order
+// they will be needed, loader threads read up to depth of them ahead of the parsers, so the
+// round trips to the share overlap with decoding and the bytes are in memory when a parser
+// gets to a file. A file taken before its turn is read on the calling thread instead.
+class FileLoader {
+public:
+    // Start reading paths in order on threads threads
+    FileLoader(std::vector<std::string> paths, int threads, std::size_t depth);
+    ~FileLoader();
+
+    FileLoader(const FileLoader&) = delete;
+    FileLoader& operator=(const FileLoader&) = delete;
+
+    // The whole contents of path, waiting while it is being read; throws if it cannot be read
+    std::string take(const std::string& path);
+
+    // A file that will not be taken, so its room in the read-ahead window is freed
+    void discard(const std::string& path);
+
+    // Getters
+    std::size_t readAhead() const { return hits; }   // Files that were in memory or in flight
+    std::size_t readOnDemand() const { return misses; }
+
+    // Read a whole file, hinting the kernel to fetch it in one go and to drop the cached pages
+    // once they were copied
+    static std::string readFile(const std::string& path);
+
+private:
+    enum class State {
+        Queued,  // Not read yet
+        Loading, // Being read by a loader thread
+        Ready,   // In memory
+        Failed,  // Could not be read; take() throws error
+        Taken    // Handed out, discarded or read by the caller
+    };
+
+    struct Entry {
+        State state = State::Queued;
+        std::string bytes;
+        std::string error;
+    };
+
+    void work();
+
+    const std::size_t depth;
+    std::vector<std::string> order;
+    std::size_t next = 0;    // Index of the next file of order to read
+    std::size_t ahead = 0;   // Files loading or loaded but not taken
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::unordered_map<std::string, Entry> entries;
+    bool stopping = false;
+    std::atomic<std::size_t> hits{0};
+    std::atomic<std::size_t> misses{0};
+    std::vector<std::thread> threads;
+};
+
+#endif // FILELOADER_HPP
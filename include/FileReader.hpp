@@ -7,9 +7,34 @@
 #include "EpitrendBinaryFormat.hpp"
 #include "EpitrendBinaryData.hpp"
 #include "RGAData.hpp"
+#include "MappedFile.hpp"
+#include "RGAScan.hpp"
+#include "RGABinKernel.hpp"
+#include <limits>
+
+// Per data item progress of an incremental Epitrend read
+struct EpitrendItemWatermark {
+    // Last sample time (days) already sent downstream
+    double sentTime = -std::numeric_limits<double>::infinity();
+
+    // File and layout of the data item when it was last decoded
+    std::string fullpath;
+    int ValueOffset = -1;
+    int TotalValues = -1;
+    EpitrendBinaryFormat::ValuePair lastPair = {0.0f, 0.0f};
+};
+using EpitrendWatermarks = std::unordered_map<std::string, EpitrendItemWatermark>;
 
 class FileReader {
 public:
+    // Column layout of an RGA data file, resolved once from its header row
+    struct RGAHeaderLayout {
+        std::size_t columnCount = 0;
+        std::size_t timeColumn = 1;     // Time Absolute (UTC), the second column unless named elsewhere
+        std::vector<int> scanColumn;    // Per file column: RGAScan column, or -1 for non-AMU columns
+        std::vector<double> amus;       // AMU of every RGAScan column
+    };
+
     // Public static method if you want to access it from other classes
     static std::string trim(const std::string& str);
 
@@ -59,6 +84,56 @@ public:
         bool verbose
     );
 
+    // Parse only the samples of the server Epitrend binary data file that are newer than
+    // each data item's watermark; unchanged data items are skipped without decoding
+    static void parseServerEpitrendBinaryDataFile(
+        const Config& config,
+        EpitrendBinaryData& binary_data,
+        const std::string& GM,
+        int year,
+        int month,
+        int day,
+        int hour,
+        EpitrendWatermarks& watermarks,
+        bool verbose
+    );
+
+    // Path of the server Epitrend binary format file of GM for the given hour
+    static std::string serverEpitrendBinaryFormatPath(
+        const Config& config,
+        const std::string& GM,
+        int year,
+        int month,
+        int day,
+        int hour
+    );
+
+    // Path of the server Epitrend binary data file of GM for the given hour
+    static std::string serverEpitrendBinaryDataPath(
+        const Config& config,
+        const std::string& GM,
+        int year,
+        int month,
+        int day,
+        int hour
+    );
+
+    // Parse an Epitrend hour whose format and binary data files were already read into memory,
+    // e.g. by a FileLoader; fullpath names the binary data file in messages
+    static void parseLoadedEpitrendBinaryDataFile(
+        const std::string& format_bytes,
+        const std::string& data_bytes,
+        const std::string& fullpath,
+        EpitrendBinaryData& binary_data,
+        bool verbose
+    );
+
+    // Advance the watermarks past all samples in sent_data (call once they are written)
+    static void commitEpitrendWatermarks(
+        const EpitrendBinaryData& sent_data,
+        EpitrendWatermarks& watermarks
+    );
+
     // Parse the RGA data file
     static void parseRGADataFile(
         RGAData& rga_data,
@@ -80,21 +155,142 @@ public:
         bool verbose
     );
 
+    // Parse a server RGA daily log already located, e.g. through a FileIndex
+    static void parseServerRGADataFile(
+        const std::string& fullpath,
+        RGAData& rga_data,
+        const std::string& GM,
+        bool verbose
+    );
+
+    // Find the server RGA daily log of GM for the given day (throws if there is none)
+    static std::string findServerRGADataFile(
+        const Config& config,
+        const std::string& GM,
+        int year,
+        int month,
+        int day,
+        bool verbose
+    );
+
+    // Check whether [begin, end) is the RGA header row and, if so, resolve its column layout
+    static bool parseRGAHeader(const char* begin, const char* end, RGAHeaderLayout& layout);
+
+    // Parse the data rows in [begin, end) straight into scan and return the bytes consumed.
+    // Only newline-terminated rows are consumed unless final is set. Malformed rows throw,
+    // or are skipped with a warning when skip_malformed is set.
+    static std::size_t parseRGARows(
+        const char* begin,
+        const char* end,
+        const RGAHeaderLayout& layout,
+        RGAScan& scan,
+        bool final,
+        bool skip_malformed,
+        const std::string& caller
+    );
+
+    // Average the scan over every AMU bin of rga_data and add the results
+    static void addRGAScan(
+        RGAData& rga_data,
+        const std::string& GM,
+        const RGAScan& scan,
+        bool verbose
+    );
+
+    // Same, for several RGAData objects (e.g. integration widths) in one pass over the scan
+    static void addRGAScan(
+        const std::vector<RGAData*>& rga_data,
+        const std::string& GM,
+        const RGAScan& scan,
+        bool verbose
+    );
+
 private:
 	// Internal use of trimming
 	static std::string trimInternal(const std::string& str);
 
+    // Internal decoding of a mapped Epitrend binary data file into binary_data
+    static void decodeEpitrendBinaryDataFile(
+        const EpitrendBinaryFormat& binary_format,
+        const std::string& fullpath,
+        EpitrendBinaryData& binary_data,
+        const std::string& caller,
+        EpitrendWatermarks* watermarks,
+        bool verbose
+    );
+
+    // Internal decoding of the bytes of an Epitrend binary data file into binary_data
+    static void decodeEpitrendBinaryData(
+        const EpitrendBinaryFormat& binary_format,
+        const char* bytes,
+        std::size_t size,
+        const std::string& fullpath,
+        EpitrendBinaryData& binary_data,
+        const std::string& caller,
+        EpitrendWatermarks* watermarks,
+        bool verbose
+    );
+
+    // Internal parse of the lines of an Epitrend binary format file
+    static EpitrendBinaryFormat readEpitrendBinaryFormat(std::istream& file, bool verbose);
+
+    // Internal path of a server Epitrend file of GM for the given hour
+    static std::string serverEpitrendHourPath(
+        const Config& config,
+        const std::string& GM,
+        int year,
+        int month,
+        int day,
+        int hour,
+        const std::string& suffix
+    );
+
+    // Internal search for the GM daily log of the given day below root
+    static std::string findRGADataFile(
+        const std::string& root,
+        const std::string& GM,
+        int year,
+        int month,
+        int day,
+        const std::string& caller,
+        bool verbose
+    );
+
+    // Internal single-pass parse of a whole RGA daily log into rga_data
+    static void parseRGADataFileAt(
+        const std::string& fullpath,
+        RGAData& rga_data,
+        const std::string& GM,
+        const std::string& caller,
+        bool verbose
+    );
+
+    // Internal parse of a numeric cell, false if it does not start with a number
+    static bool parseRGANumber(const char* begin, const char* end, double& value);
+
+    // Internal parsing of the server Epitrend binary data file, incremental when watermarks are given
+    static void readServerEpitrendBinaryDataFile(
+        const Config& config,
+        EpitrendBinaryData& binary_data,
+        const std::string& GM,
+        int year,
+        int month,
+        int day,
+        int hour,
+        EpitrendWatermarks* watermarks,
+        bool verbose
+    );
+
     // Internal using of splitting by delimiter
-    static std::vector<std::string> split(std::string s, const std::string& delimiter) {
+    static std::vector<std::string> split(const std::string& s, const std::string& delimiter) {
         std::vector<std::string> tokens;
+        size_t start = 0;
         size_t pos = 0;
-        std::string token;
-        while ((pos = s.find(delimiter)) != std::string::npos) {
-            token = s.substr(0, pos);
-            tokens.push_back(token);
-            s.erase(0, pos + delimiter.length());
+        while ((pos = s.find(delimiter, start)) != std::string::npos) {
+            tokens.emplace_back(s, start, pos - start);
+            start = pos + delimiter.length();
         }
-        tokens.push_back(s);
+        tokens.emplace_back(s, start);
 
         return tokens;
     }
@@ -0,0 +1,54 @@
+#ifndef GZIPCOMPRESSOR_HPP
+#define GZIPCOMPRESSOR_HPP
+
+#include "Common.hpp"
+#include "RequestBody.hpp"
+
+#include <zlib.h>
+
+// Gzip compression of request bodies with one reusable zlib stream and output buffer.
+// Also tracks the compressed/uncompressed ratio of recent bodies, so callers can size
+// batches by the bytes that will actually go over the network.
+class GzipCompressor {
+public:
+    // Constructors and destructors (level 1 = fastest ... 9 = smallest)
+    explicit GzipCompressor(int level = Z_DEFAULT_COMPRESSION);
+    ~GzipCompressor();
+
+    // The zlib stream is owned, so copies are not allowed
+    GzipCompressor(const GzipCompressor&) = delete;
+    GzipCompressor& operator=(const GzipCompressor&) = delete;
+
+    // Compress length bytes into a complete gzip member; the result stays valid
+    // until the next call
+    const std::string& compress(const char* data, std::size_t length);
+    const std::string& compress(const std::string& data) { return compress(data.data(), data.size()); }
+
+    // Compress a streamed body piece by piece, without joining it first
+    const std::string& compress(RequestBody& source);
+
+    // The contents of a complete gzip member, for the rare caller that needs a body back
+    static std::string decompress(const std::string& gzipped);
+
+    // Getters
+    int level() const { return level_; }
+    double ratio() const { return ratio_; }
+
+    // Compressed size expected for uncompressed_bytes at the observed ratio
+    std::size_t estimate(std::size_t uncompressed_bytes) const {
+        return static_cast<std::size_t>(static_cast<double>(uncompressed_bytes) * ratio_);
+    }
+
+private:
+    void reset(std::size_t length);
+    void deflateInput(const char* data, std::size_t length, int flush);
+    void recordRatio(std::size_t length);
+
+    z_stream stream;
+    std::string out;
+    int level_;
+    double ratio_ = 0.25; // Conservative until the first body is seen
+    bool sampled = false;
+};
+
+#endif // GZIPCOMPRESSOR_HPP
@@ -5,20 +5,13 @@
 #include "influxdb.hpp"
 #include "EpitrendBinaryData.hpp"
 #include "RGAData.hpp"
-
-#include <curl/curl.h>
-
-// Helper class to properly handle curl headers and prevent memory allocation issues
-class CurlHeaders {
-public:
-    CurlHeaders() : headers_(nullptr) {}
-    ~CurlHeaders() { if (headers_) curl_slist_free_all(headers_); }
-    void append(const std::string& header);
-    struct curl_slist* get() const { return headers_; }
-
-private:
-    struct curl_slist* headers_;
-};
+#include "LineProtocolEncoder.hpp"
+#include "CurlSession.hpp"
+#include "GzipCompressor.hpp"
+#include "SharedSink.hpp"
+#include "Batcher.hpp"
+#include "WriteSpool.hpp"
+#include "Scheduler.hpp"
 
 class InfluxDatabase {
 public:
@@ -31,6 +24,10 @@ public:
     InfluxDatabase();
     ~InfluxDatabase();
 
+    // Each object owns a keep-alive connection, so share it by reference instead of copying
+    InfluxDatabase(const InfluxDatabase&) = delete;
+    InfluxDatabase& operator=(const InfluxDatabase&) = delete;
+
     // Connection and disconnections
     bool connect(const std::string& host, int port,
                 const std::string& org, const std::string& bucket, 
@@ -53,15 +50,66 @@ public:
     // Writing batch to bucket
     bool writeBatchData(const std::vector<std::string>& dataPoints, bool verbose = false);
     bool writeBatchData2(const std::vector<std::string>& dataPoints, bool verbose = false);
+    bool writeBatchData2(const std::string& lineProtocol, bool verbose = false);
 
     // Parsing query
     std::vector<std::unordered_map<std::string, std::string>> parseQueryResult(const std::string& response);
     std::vector<std::unordered_map<std::string,std::string>> parseQueryResponse(std::string& response, bool verbose = false);
 
     // Copying to bucket
-    bool copyEpitrendToBucket(EpitrendBinaryData data, bool verbose = false);
-    bool copyEpitrendToBucket2(EpitrendBinaryData data, bool verbose = false);
-    bool copyRGADataToBucket(RGAData data, bool verbose = false);
+    bool copyEpitrendToBucket(const EpitrendBinaryData& data, bool verbose = false);
+    bool copyEpitrendToBucket2(const EpitrendBinaryData& data, bool verbose = false);
+    bool copyRGADataToBucket(const RGAData& data, bool verbose = false);
+
+    // A ts batch encoded ahead of its send, e.g. by another stage of a pipeline
+    struct EncodedBatch {
+        std::string lines;
+        std::vector<int> sensorIds;
+        std::size_t points = 0;
+        std::size_t first = 0; // Index of its first sample over all series of the data, in order
+    };
+
+    // The two halves of a copy call, for pipelines that encode and send on different threads.
+    // encodeBatches may run on several threads at once. sendBatches hands the lines over to
+    // the sink without copying them and waits until the server accepted every batch; when it
+    // throws, batches holds only the ones that failed, without their lines. encodeAgain
+    // encodes those lines once more from the same data, so a retry sends only those batches.
+    std::vector<EncodedBatch> encodeBatches(const EpitrendBinaryData& data, bool verbose = false);
+    std::vector<EncodedBatch> encodeBatches(const RGAData& data, bool verbose = false);
+    void sendBatches(std::vector<EncodedBatch>& batches, bool verbose = false);
+    void encodeAgain(const EpitrendBinaryData& data, EncodedBatch& batch, bool verbose = false);
+    void encodeAgain(const RGAData& data, EncodedBatch& batch, bool verbose = false);
+
+    // Epitrend samples are float32 on disk; write them at float precision (default) or full double
+    void setEpitrendFloatPrecision(bool float_precision) { epitrendFloatPrecision_ = float_precision; }
+
+    // Gzip the bodies of v2 writes at level 1-9 (0 turns it off)
+    void setGzipCompression(int level);
+
+    // When the copy calls close a ts batch; byte limits count the bytes sent, so compressed
+    // bytes when gzip is on
+    void setBatchPolicy(const BatchPolicy& policy) { batcher_.setPolicy(policy); }
+
+    // Number of ts batches kept in flight to this bucket while the next ones are encoded; the
+    // writes go through the shared sink, which gives each setting its own writer
+    void setMaxInFlightWrites(int max_in_flight);
+
+    // Append the ts batches of the copy calls to a disk spool in directory and ship them from
+    // a drain thread, so the copy calls never wait for the server; resumes what an earlier
+    // run left in the spool
+    void enableSpool(const std::string& directory);
+
+    // Priority class of the writes of this connection (default real-time): the shared sink
+    // and its writer queue them apart from the other class, and backfill writes, spooled or
+    // not, stay within the backfill share of the requests in flight
+    void setWritePriority(Priority priority) { writePriority_ = priority; }
+
+    // Health of the connected server, shared with every other connection to it; callers
+    // wait on it before they try again after a failure
+    CircuitBreaker& breaker() { return *breaker_; }
+
+    // Drop the cached sensor ids of this bucket and read them again from the ns measurement
+    void resyncSensorIds(bool verbose = false);
 
 
 private:
@@ -75,8 +123,74 @@ private:
     std::string precision_;
     std::string token_;
     bool isConnected;
-
-    static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* s);
+    bool epitrendFloatPrecision_ = true;
+
+    // Keep-alive connection used by every write and query of this object
+    CurlSession session;
+    CircuitBreaker* breaker_ = nullptr;
+    std::string writeUrl_;
+    std::string queryUrl_;
+
+    // Optional gzip of write bodies; the shared sink compresses the ts batches it merges
+    std::unique_ptr<GzipCompressor> gzip_;
+
+    // Internal v2 write of a body that is already gzipped when gzipped is true
+    void sendWriteBody(RequestBody& body, bool gzipped, bool verbose);
+
+    // Batching of the copy calls, fed with the latency of every write to this bucket
+    Batcher batcher_;
+
+    // Internal v1 API request (write/query) through the session, a GET when body is null;
+    // returns 0 on a 2xx status
+    long requestV1(const char* uri, const std::string& querystring,
+        RequestBody* body, std::string& response);
+
+    // Timestamp of every ns row, so rewriting a row replaces it
+    static constexpr const char* NS_DEFAULT_TIMESTAMP = "2000000000000";
+
+    // Asynchronous ts writes of the copy calls through the shared sink, looked up on first use
+    int maxInFlightWrites_ = AsyncWriter::DEFAULT_MAX_IN_FLIGHT;
+    std::shared_ptr<SharedSink::Destination> destination_;
+    std::mutex destinationMutex_;
+    const std::shared_ptr<SharedSink::Destination>& sinkDestination();
+    const std::uint64_t sinkOrigin_ = SharedSink::instance().newOrigin(); // Orders its writes apart from other connections
+
+    // Optional spool in front of the sink
+    std::unique_ptr<WriteSpool> spool_;
+    Priority writePriority_ = Priority::RealTime;
+
+    // Internal switch to a new destination (and drain) after a write setting changed
+    void resetDestination();
+    void startSpoolDrain();
+
+    // Each spooled batch is tried this often before the drain pauses and sends it again
+    static constexpr int SPOOL_RETRY_CALLS = 5;
+
+    // Internal hand-over of an encoded batch to the spool or the shared sink
+    std::future<void> submitBatch(std::string lines, std::vector<int> sensor_ids, int retry_calls);
+
+    // Internal encoding of count samples from the first one on, over all series in order, into
+    // batches closed at the limits when split is set, else into one batch
+    template <typename Series, typename ToTimestamp>
+    std::vector<EncodedBatch> encodeSeries(const std::vector<Series>& all_series,
+        const std::vector<int>& sensor_ids, ToTimestamp to_timestamp, bool float_precision,
+        std::size_t first, std::size_t count, bool split);
+    std::vector<EncodedBatch> encodeRange(const EpitrendBinaryData& data, std::size_t first, std::size_t count,
+        bool split, bool verbose);
+    std::vector<EncodedBatch> encodeRange(const RGAData& data, std::size_t first, std::size_t count,
+        bool split, bool verbose);
+
+    // Internal wait for every submitted batch; throws if any of them failed, with their indices
+    // in failed
+    void waitForWrites(std::vector<std::future<void>>& writes, std::vector<std::size_t>& failed,
+                       const std::string& caller, bool verbose);
+
+    // Internal sensor id handling through the shared SensorRegistry; concurrent encoders
+    // take sessionMutex_, as the lookups query through the session
+    std::mutex sessionMutex_;
+    void refreshSensorIds(const std::string& caller, bool verbose);
+    std::vector<int> resolveSensorIds(const std::vector<std::string>& names,
+        const std::string& machine_name, const std::string& caller, bool verbose);
 
     // Internal using of splitting by delimiter
     static std::vector<std::string> split(std::string s, const std::string& delimiter);
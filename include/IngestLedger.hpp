@@ -0,0 +1,78 @@
+#ifndef INGESTLEDGER_HPP
+#define INGESTLEDGER_HPP
+
+#include "Common.hpp"
+
+#include <limits>
+#include <mutex>
+
+// What was ingested from one source file
+struct LedgerEntry {
+    std::uintmax_t size = 0;
+    std::int64_t mtime = 0;
+    std::uint32_t hash = 0;    // Fingerprint of the content, see IngestLedger::fingerprint
+    std::uint64_t points = 0;  // Samples written from the file so far
+    double watermark = -std::numeric_limits<double>::infinity(); // Every sample up to it was acknowledged
+};
+
+// Process-wide ledger of the source files already loaded, so a restart skips unchanged files
+// and resumes growing ones instead of sending everything again. Backed by an append-only
+// local file (size, mtime, hash, points, watermark, path per tab-separated line; a later line
+// for the same path wins) that is compacted when it is opened. Callers record a file only
+// once the sink acknowledged its samples; a spooled batch counts, as the spool survives a
+// restart.
+class IngestLedger {
+public:
+    enum class Plan {
+        Load,   // New or rewritten: ingest the whole file
+        Resume, // Grown since it was recorded: ingest the samples after its watermark
+        Skip    // Unchanged since it was recorded
+    };
+
+    static IngestLedger& instance();
+
+    // Load the local file (if it exists) and append to it from now on
+    void open(const std::string& path);
+
+    // Compare the file on disk with its entry. observed gets the current size, mtime and hash,
+    // and on Resume the recorded points and watermark; pass it to record() after the ack.
+    Plan plan(const std::string& path, LedgerEntry& observed);
+
+    // Whether path is recorded with this size and mtime, so plan() would skip it; lets callers
+    // drop files from a listing without touching them
+    bool unchanged(const std::string& path, std::uintmax_t size, std::int64_t mtime) const;
+
+    // Record a file as ingested up to observed.watermark
+    void record(const std::string& path, const LedgerEntry& observed);
+
+    // Fast content hash: crc32 of the size and of the first and last FINGERPRINT_BLOCK bytes
+    static std::uint32_t fingerprint(const std::string& path, std::uintmax_t size);
+
+    // Watermark of freshly parsed data: the earliest last sample over its series, so resuming
+    // from it may resend a few samples of other series but never skips one
+    template <typename Data>
+    static double watermarkOf(const Data& data) {
+        double watermark = std::numeric_limits<double>::infinity();
+        for (const auto& series : data.getAllSeries()) {
+            if (!series.samples.empty()) {
+                watermark = std::min(watermark, series.samples.times.back());
+            }
+        }
+        return std::isinf(watermark) ? -std::numeric_limits<double>::infinity() : watermark;
+    }
+
+    static constexpr std::size_t FINGERPRINT_BLOCK = 64 * 1024;
+
+private:
+    IngestLedger() = default;
+
+    // Caller holds the mutex
+    void append(const std::string& path, const LedgerEntry& entry);
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, LedgerEntry> entries;
+    std::string ledgerPath;
+    std::ofstream file;
+};
+
+#endif // INGESTLEDGER_HPP
@@ -0,0 +1,51 @@
+#ifndef LINEPROTOCOLENCODER_HPP
+#define LINEPROTOCOLENCODER_HPP
+
+#include "Common.hpp"
+
+// Builds an InfluxDB line-protocol request body in one reusable byte buffer.
+// Numbers are written with std::to_chars: integers exactly, doubles in their shortest
+// round-trip form, and float32-sourced values optionally at float precision.
+class LineProtocolEncoder {
+public:
+    // Constructors
+    explicit LineProtocolEncoder(std::size_t reserve_bytes = DEFAULT_RESERVE_BYTES);
+
+    // Append one "ts,sensor_id_=<id> num=<value> <timestamp>" point.
+    // Non-finite values cannot be written in line protocol, so they are skipped (returns false).
+    bool appendTsPoint(int sensor_id, double value, long long timestamp, bool float_precision = false);
+
+    // Building blocks for other measurements
+    void appendRaw(const char* text, std::size_t length) { body.append(text, length); }
+    void appendRaw(const std::string& text) { body.append(text); }
+    void appendInteger(long long value);
+    void appendDouble(double value);
+    void appendFloat(float value);
+    void endLine();
+
+    // Getters
+    const std::string& buffer() const { return body; }
+    std::size_t size() const { return body.size(); }
+    std::size_t pointCount() const { return points; }
+    bool empty() const { return points == 0; }
+
+    // Sensor ids of the ts points in the buffer, in first-seen order
+    const std::vector<int>& sensorIds() const { return sensors; }
+
+    // Utility Methods
+    void clear();
+
+    // Hand the buffer over (e.g. to an asynchronous write) and start a new, empty one
+    std::string take();
+
+    // Room for about 5000 points; bigger batches grow the buffer
+    static constexpr std::size_t DEFAULT_RESERVE_BYTES = 5000 * 48;
+
+private:
+    std::string body;
+    std::size_t points = 0;
+    std::vector<int> sensors;
+    std::size_t reserveBytes;
+};
+
+#endif // LINEPROTOCOLENCODER_HPP
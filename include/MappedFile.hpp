@@ -0,0 +1,41 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include "Common.hpp"
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+public:
+    // Constructors and destructors
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    // Mappings are owned, so only moves are allowed
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Getters
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool is_open() const { return isOpen_; }
+
+    // View the mapped bytes as a read-only array of T (a trailing partial T is ignored)
+    template <typename T>
+    const T* as() const { return reinterpret_cast<const T*>(data_); }
+
+    template <typename T>
+    std::size_t count() const { return size_ / sizeof(T); }
+
+    // Utility Methods
+    void close();
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool isOpen_ = false;
+};
+
+#endif // MAPPEDFILE_HPP
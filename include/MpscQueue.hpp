@@ -0,0 +1,57 @@
+#ifndef MPSCQUEUE_HPP
+#define MPSCQUEUE_HPP
+
+#include <atomic>
+#include <utility>
+
+// Unbounded lock-free multi-producer single-consumer FIFO (Vyukov's node queue). push() may
+// be called from any thread and never blocks or waits on another producer; pop() and
+// empty() belong to the one consumer thread. The consumed node becomes the next dummy, so
+// every push costs one allocation and nothing else is shared between the two sides.
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head(new Node()), tail(head.load(std::memory_order_relaxed)) {}
+
+    ~MpscQueue() {
+        T discarded;
+        while (pop(discarded)) {
+        }
+        delete tail;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Node* node = new Node();
+        node->value = std::move(value);
+        Node* previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // False when empty, or while the producer of the next element is still linking it in
+    bool pop(T& out) {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) {
+            return false;
+        }
+        out = std::move(next->value);
+        delete tail;
+        tail = next;
+        return true;
+    }
+
+    bool empty() const { return tail->next.load(std::memory_order_acquire) == nullptr; }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value;
+    };
+
+    std::atomic<Node*> head; // Last node, swapped by producers
+    Node* tail;              // Dummy before the first element, consumer only
+};
+
+#endif // MPSCQUEUE_HPP
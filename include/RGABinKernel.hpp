@@ -0,0 +1,41 @@
+#ifndef RGABINKERNEL_HPP
+#define RGABINKERNEL_HPP
+
+#include "Common.hpp"
+#include "RGAData.hpp"
+#include "RGAScan.hpp"
+
+#include <cstdint>
+
+// Precomputed mapping from the AMU columns of one RGA header layout to a list of interned AMU bins.
+// Every bin is stored as runs of consecutive scan columns, so its average over a row is a
+// couple of differences of that row's prefix sums. Bins of several integration widths can
+// share one kernel and are then all produced by the same pass over the scan.
+class RGABinKernel {
+public:
+    // Constructors
+    RGABinKernel(const std::vector<double>& amus, const std::vector<RGAData::BinId>& bins, bool verbose = false);
+
+    // Getters
+    std::size_t binCount() const { return inverseCount.size(); }
+    std::size_t columnCount() const { return columns; }
+    bool hasColumns(std::size_t bin) const { return runOffsets[bin + 1] > runOffsets[bin]; }
+
+    // Average every bin over every row of scan into averages (rows x binCount(), row-major).
+    // Rows are split across up to max_threads threads (0 = hardware concurrency).
+    void integrate(const RGAScan& scan, std::vector<double>& averages, unsigned max_threads = 0) const;
+
+private:
+    // Rows handed to one thread at least, below this threading costs more than it saves
+    static constexpr std::size_t MIN_ROWS_PER_THREAD = 256;
+
+    void integrateRows(const RGAScan& scan, std::size_t first, std::size_t last, double* averages) const;
+
+    std::size_t columns = 0;
+    std::vector<std::uint32_t> runOffsets;  // Runs of bin b are [runOffsets[b], runOffsets[b + 1])
+    std::vector<std::uint32_t> runBegin;    // First scan column of every run
+    std::vector<std::uint32_t> runEnd;      // One past the last scan column of every run
+    std::vector<double> inverseCount;       // 1 / number of columns found for every bin (0 if none)
+};
+
+#endif // RGABINKERNEL_HPP
@@ -3,6 +3,11 @@
 
 #include "Common.hpp"
 #include "Config.hpp"
+#include "TimeSeries.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
 
 class RGAData {
 public:
@@ -78,15 +83,48 @@ public:
         }
     };
 
-    // Custom hash function for AMUBins
-    struct AMUBinsHash {
-        std::size_t operator()(const AMUBins& amubins) const {
-            std::size_t seed = 0;
-            for (const auto& bin : amubins.bins) {
-                seed ^= std::hash<double>()(bin) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-            }
-            return seed;
-        }
+    // Small integer ID of an interned (GM, bin set) layout
+    using BinId = std::uint32_t;
+
+    // Process-wide registry interning every (GM, bin set) layout once.
+    // Layouts are never removed, so IDs and the references handed out stay valid.
+    class BinRegistry {
+    public:
+        static BinRegistry& instance();
+
+        // ID of the layout, registering it on first use
+        BinId intern(const AMUBins& bins);
+
+        // ID of the same bin set as id under another GM
+        BinId intern(BinId id, const std::string& GM);
+
+        // Getters
+        const AMUBins& bins(BinId id) const;
+        const std::string& name(BinId id) const;  // binsString(), computed once
+
+    private:
+        BinRegistry() = default;
+
+        // Bins are compared with FloatCompare's tolerance, so key them in units of it
+        using LayoutKey = std::pair<std::string, std::vector<long long>>;
+        static LayoutKey keyOf(const std::string& GM, const std::set<double, std::less<>>& bins);
+        BinId internKey(LayoutKey key, const AMUBins& bins);
+
+        struct Layout {
+            AMUBins bins;
+            std::string name;
+            std::vector<long long> binKey;
+        };
+
+        mutable std::mutex mutex;
+        std::deque<Layout> layouts;
+        std::map<LayoutKey, BinId> ids;
+    };
+
+    // Columnar series of one interned layout
+    struct Series {
+        BinId id;
+        TimeSeries samples;
     };
 
 public:
@@ -96,20 +134,40 @@ public:
 
     // Getters and Setters
     void addData(const AMUBins& bins, double time, double value);
+    void addData(BinId id, double time, double value);
+
+    // Bulk append of count time,value samples for one layout
+    void appendRange(BinId id, const double* times, const double* values, std::size_t count);
+
+    // Append every series of other, e.g. to merge files parsed one by one
+    void append(const RGAData& other);
+
+    // Remove the samples at or before time from every series, e.g. those already ingested
+    void dropThrough(double time);
+
     int getByteSize() const;
-    const std::unordered_map<AMUBins, std::unordered_map<double, double, std::hash<double>, std::equal_to<double>, std::allocator<std::pair<const double, double>>>, AMUBinsHash, std::equal_to<AMUBins>, std::allocator<std::pair<const AMUBins, std::unordered_map<double, double, std::hash<double>, std::equal_to<double>, std::allocator<std::pair<const double, double>>>>>>& getAllTimeSeriesData() const;
-    const std::vector<AMUBins> getBins();
+    const std::vector<Series>& getAllSeries() const;
+    const Series* findSeries(BinId id) const;
+    std::size_t getSampleCount() const;
+
+    // Layouts this object integrates, in construction order
+    const std::vector<BinId>& getBinIds() const;
 
     // Utility
-    void printAllTimeSeriesData();
-    void printFileAllTimeSeriesData(const Config& config, const std::string& filename);
+    void printAllTimeSeriesData() const;
+    void printFileAllTimeSeriesData(const Config& config, const std::string& filename) const;
     void clearData();
-    RGAData difference(const RGAData& other) const;
     bool is_empty() const;
 
 private:
-    std::unordered_map<AMUBins, std::unordered_map<double, double>, AMUBinsHash> allTimeSeriesData;
+    // Series are stored densely; seriesSlot maps a BinId to its series (-1 if absent)
+    Series& seriesFor(BinId id);
+
+    std::vector<Series> allSeries;
+    std::vector<std::int32_t> seriesSlot;
+    std::vector<int> bytesPerSample;   // Per series: 8 bytes * 2 + 8 bytes * number of bins
+    std::vector<BinId> binIds;
     int byteSize = 0;
 };
 
-#endif // RGADATA_HPP
\ No newline at end of file
+#endif // RGADATA_HPP
@@ -0,0 +1,24 @@
+#ifndef RGASCAN_HPP
+#define RGASCAN_HPP
+
+#include "Common.hpp"
+
+// Dense row-major matrix of RGA scans: one row per scan time, one column per AMU
+struct RGAScan {
+    std::vector<double> amus;    // AMU of every column, in header order
+    std::vector<double> times;   // Unix time (seconds) of every row
+    std::vector<float> values;   // rows() x columns() partial pressures
+
+    // Getters
+    std::size_t rows() const { return times.size(); }
+    std::size_t columns() const { return amus.size(); }
+    const float* row(std::size_t i) const { return values.data() + i * amus.size(); }
+
+    // Utility Methods
+    void clear() {
+        times.clear();
+        values.clear();
+    }
+};
+
+#endif // RGASCAN_HPP
@@ -0,0 +1,54 @@
+#ifndef RGATAILREADER_HPP
+#define RGATAILREADER_HPP
+
+#include "Common.hpp"
+#include "FileReader.hpp"
+#include "RGAData.hpp"
+
+#include <sys/types.h>
+
+// Incremental reader for the append-only RGA daily logs.
+// Remembers, per (GM, day), which file was read, its header layout and how many
+// bytes were consumed, so each poll only parses the rows appended since the last one.
+class RGATailReader {
+public:
+    // Constructors
+    RGATailReader() = default;
+
+    // Parse the rows appended to the GM daily log of the given day since the last poll.
+    // Returns the number of new rows; throws like FileReader::parseServerRGADataFile.
+    // The rows count as read once parsed, so the caller keeps those it could not send.
+    std::size_t poll(
+        const Config& config,
+        RGAData& rga_data,
+        const std::string& GM,
+        int year,
+        int month,
+        int day,
+        bool verbose = false
+    );
+
+    // Utility Methods
+    bool isClosed(const std::string& GM, int year, int month, int day) const;
+    std::string fullpath(const std::string& GM, int year, int month, int day) const; // Empty before the first poll
+    void clear();
+
+private:
+    struct LogState {
+        std::string fullpath;
+        dev_t device = 0;
+        ino_t inode = 0;
+        std::uintmax_t offset = 0;        // Bytes consumed, always at a line boundary
+        bool headerFound = false;
+        FileReader::RGAHeaderLayout layout;
+        bool closed = false;              // Past day read to the end, never touched again
+    };
+
+    // Past days whose file has not changed for this long are considered finished
+    static constexpr int CLOSE_AFTER_SECONDS = 600;
+
+    using LogKey = std::tuple<std::string, int, int, int>;
+    std::map<LogKey, LogState> logs;
+};
+
+#endif // RGATAILREADER_HPP
@@ -0,0 +1,33 @@
+#ifndef REJECTLOG_HPP
+#define REJECTLOG_HPP
+
+#include "Common.hpp"
+
+#include <mutex>
+
+// Process-wide quarantine of line-protocol lines the server refused. Each entry is a
+// "# <time> <bucket> <reason>" comment followed by the refused lines, appended to one file
+// so they can be inspected and replayed by hand.
+class RejectLog {
+public:
+    static RejectLog& instance();
+
+    // Append to path from now on
+    void open(const std::string& path);
+
+    // Record lines (newline-terminated) refused with reason
+    void quarantine(const std::string& bucket, const std::string& reason, const std::string& lines);
+
+    // Number of lines quarantined since startup
+    std::size_t count() const;
+
+private:
+    RejectLog() = default;
+
+    mutable std::mutex mutex;
+    std::string path;
+    std::ofstream file;
+    std::size_t lines = 0;
+};
+
+#endif // REJECTLOG_HPP
@@ -0,0 +1,65 @@
+#ifndef REQUESTBODY_HPP
+#define REQUESTBODY_HPP
+
+#include "Common.hpp"
+
+#include <curl/curl.h>
+
+// Pull-style HTTP request body: curl asks for the next bytes while it sends, so a batch is
+// streamed from where it was built instead of being joined into one more string first
+class RequestBody {
+public:
+    virtual ~RequestBody() = default;
+
+    // Total bytes, or UNKNOWN_SIZE to send the body chunked
+    virtual curl_off_t size() const = 0;
+
+    // Copy up to length of the next bytes to dest; 0 at the end of the body
+    virtual std::size_t read(char* dest, std::size_t length) = 0;
+
+    // Start again from the first byte (curl rewinds for retries and redirects)
+    virtual void rewind() = 0;
+
+    // Stream this body as the POST data of handle
+    void attach(CURL* handle);
+
+    static constexpr curl_off_t UNKNOWN_SIZE = -1;
+
+private:
+    static size_t ReadCallback(char* dest, size_t size, size_t nmemb, void* userp);
+    static int SeekCallback(void* userp, curl_off_t offset, int origin);
+};
+
+// Body read straight out of one contiguous buffer, e.g. a LineProtocolEncoder's
+class BufferBody : public RequestBody {
+public:
+    BufferBody(const char* data, std::size_t length) : data(data), length(length) {}
+    explicit BufferBody(const std::string& buffer) : BufferBody(buffer.data(), buffer.size()) {}
+
+    curl_off_t size() const override { return static_cast<curl_off_t>(length); }
+    std::size_t read(char* dest, std::size_t max_length) override;
+    void rewind() override { offset = 0; }
+
+private:
+    const char* data;
+    std::size_t length;
+    std::size_t offset = 0;
+};
+
+// Body of newline-terminated lines read from the caller's vector without joining them
+class LinesBody : public RequestBody {
+public:
+    explicit LinesBody(const std::vector<std::string>& lines);
+
+    curl_off_t size() const override { return static_cast<curl_off_t>(length); }
+    std::size_t read(char* dest, std::size_t max_length) override;
+    void rewind() override { line = 0; offset = 0; }
+
+private:
+    const std::vector<std::string>& lines;
+    std::size_t length = 0;
+    std::size_t line = 0;
+    std::size_t offset = 0; // Into lines[line]; lines[line].size() is its '\n'
+};
+
+#endif // REQUESTBODY_HPP
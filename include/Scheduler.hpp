@@ -0,0 +1,75 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include "Common.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+
+// Priority classes of ingest jobs, highest first
+enum class Priority { RealTime = 0, Backfill = 1 };
+constexpr std::size_t PRIORITY_CLASSES = 2;
+
+// Queue depth and wait times of one priority class
+struct SchedulerStats {
+    std::size_t queued = 0;
+    std::size_t running = 0;
+    std::uint64_t completed = 0;
+    std::chrono::milliseconds totalWait{0};
+    std::chrono::milliseconds maxWait{0};
+};
+
+// Process-wide worker pool that runs the CPU work of ingest (parsing the share and encoding
+// batches); waits for the server stay on the threads that send. Workers always take real-time jobs first. Backfill jobs only start while no
+// real-time job is waiting, and at most backfillShare of the workers run them at a time, so a
+// real-time job never waits behind a full pool of backfill work. The writers of the sink hold
+// backfill to the same share of their requests in flight.
+class Scheduler {
+public:
+    static Scheduler& instance();
+
+    // Start workers threads; backfill may use backfill_share (0-1] of them, at least one
+    void start(int workers, double backfill_share);
+
+    // Queue a job; the future holds its exception, if any. Before start() the job runs at
+    // once on the calling thread, so the write paths work without a pool too.
+    std::future<void> submit(Priority priority, std::function<void()> job);
+
+    // Queue a job and wait for it; rethrows its exception
+    void run(Priority priority, std::function<void()> job);
+
+    // Block while real-time jobs are queued; for backfill work that runs off the pool
+    void yieldToRealTime();
+
+    // Getters
+    double backfillShare() const { return backfillShare_; } // 1 before start()
+    SchedulerStats stats(Priority priority) const;
+    std::string report() const; // One line with the stats of every class
+
+private:
+    Scheduler() = default;
+    ~Scheduler() = delete; // Workers run until the process ends
+
+    struct Job {
+        std::packaged_task<void()> task;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    void work();
+
+    // Next job a worker may start, by priority and backfill share; caller holds the mutex
+    bool take(Job& job, Priority& priority);
+
+    mutable std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Job> queues[PRIORITY_CLASSES];
+    SchedulerStats stats_[PRIORITY_CLASSES];
+    std::size_t backfillSlots = 1;
+    std::atomic<double> backfillShare_{1.0};
+    std::vector<std::thread> workers;
+};
+
+#endif // SCHEDULER_HPP
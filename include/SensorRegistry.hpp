@@ -0,0 +1,54 @@
+#ifndef SENSORREGISTRY_HPP
+#define SENSORREGISTRY_HPP
+
+#include "Common.hpp"
+
+#include <mutex>
+
+// Process-wide cache of the sensor-name -> sensor-id pairs of the ns measurement, per bucket.
+// Backed by an append-only local file (bucket, sensor name, sensor id per tab-separated line)
+// that is read once through a mapping at startup, so a warm process resolves ids without
+// querying the server. New ids are handed out under one lock, so threads sharing a bucket
+// cannot race on them; they stay pending until the caller has written their ns rows.
+class SensorRegistry {
+public:
+    static SensorRegistry& instance();
+
+    // Load the local file (if it exists) and append to it from now on
+    void open(const std::string& path);
+
+    // Sensor id of every name, or -1 where it is not known yet
+    std::vector<int> lookup(const std::string& bucket, const std::vector<std::string>& names) const;
+
+    // Merge the (sensor name, sensor id) pairs read from the server's ns measurement
+    void merge(const std::string& bucket, const std::vector<std::pair<std::string, int>>& entries);
+
+    // Reserve ids for names that are still unknown after a refresh; a name that is already
+    // pending keeps its id. The ns rows of the result must then be written and confirm()ed.
+    std::vector<std::pair<std::string, int>> reserve(const std::string& bucket, const std::vector<std::string>& names);
+
+    // Mark reserved ids as written to the ns measurement
+    void confirm(const std::string& bucket, const std::vector<std::pair<std::string, int>>& entries);
+
+    // Forget everything known about bucket, so the next lookup refreshes from the server
+    void invalidate(const std::string& bucket);
+
+private:
+    SensorRegistry() = default;
+
+    struct BucketIds {
+        std::unordered_map<std::string, int> ids;      // Confirmed in ns
+        std::unordered_map<std::string, int> pending;  // Reserved, ns row not written yet
+        int maxId = 0;
+    };
+
+    // Caller holds the mutex
+    void setId(BucketIds& bucket_ids, const std::string& bucket, const std::string& name, int id, bool persist);
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, BucketIds> buckets;
+    std::string path;
+    std::ofstream file;
+};
+
+#endif // SENSORREGISTRY_HPP
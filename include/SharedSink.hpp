@@ -0,0 +1,102 @@
+#ifndef SHAREDSINK_HPP
+#define SHAREDSINK_HPP
+
+#include "Common.hpp"
+#include "AsyncWriter.hpp"
+#include "Batcher.hpp"
+#include "MpscQueue.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+
+// Process-wide write stage shared by every InfluxDatabase. Producers push encoded chunks
+// onto a lock-free queue and go on; a sink thread merges the chunks of each destination
+// (write url) into large bodies under the coalesce policy and hands them to one
+// AsyncWriter per destination. Connections and requests scale with the destinations, not
+// with the threads that produce data.
+//
+// Every priority class has its own queue, sink thread and open bodies per destination, and
+// its bodies go to their own queue of the writer: real-time chunks are never merged with
+// backfill ones, nor wait while the sink thread is held up by a full backfill queue.
+//
+// Chunks are only merged with chunks of the same origin (one per connection), and the writer
+// orders bodies per origin and sensor. A merged body so only waits for earlier bodies of its
+// own origin that share a sensor, not for every body that holds one of its many sensors.
+class SharedSink {
+public:
+    // Writes to one url, shared by every connection that writes there
+    class Destination;
+
+    static SharedSink& instance();
+
+    // The destination of url with these settings, created on first use; a connection that
+    // asks for another token, gzip level or max_in_flight gets a writer of its own
+    std::shared_ptr<Destination> destination(const std::string& url, const std::string& token,
+        const std::string& bucket, int max_in_flight, int gzip_level, CircuitBreaker* breaker);
+
+    // A new origin for push(), one per connection
+    std::uint64_t newOrigin() { return nextOrigin++; }
+
+    // Hand over newline-terminated lines; never blocks. The future is resolved when the body
+    // they were merged into is done.
+    std::future<void> push(const std::shared_ptr<Destination>& destination, std::string lines,
+                           std::vector<int> sensor_ids, int attempts, Priority priority, std::uint64_t origin);
+
+    // Compressed/uncompressed ratio of the recent bodies of destination (1 without gzip)
+    double compressionRatio(const std::shared_ptr<Destination>& destination) const;
+
+    // Report the write latency of a destination to batcher until unwatch()
+    void watch(const std::shared_ptr<Destination>& destination, Batcher* batcher);
+    void unwatch(const std::shared_ptr<Destination>& destination, Batcher* batcher);
+
+    // Setters
+    void setPolicy(const BatchPolicy& policy);
+
+private:
+    SharedSink();
+    ~SharedSink() = delete; // Never destroyed; writes in flight at exit stay in the spool
+
+    struct Chunk {
+        std::shared_ptr<Destination> destination;
+        std::string lines;
+        std::vector<int> sensorIds;
+        int attempts = 1;
+        std::uint64_t origin = 0;
+        std::shared_ptr<std::promise<void>> done;
+    };
+
+    // Open body of an origin at a destination in one class, touched by the sink thread of the
+    // class only
+    struct Body;
+
+    // Queue and sink thread of one priority class
+    struct Lane {
+        MpscQueue<Chunk> queue;
+
+        // Wake-up of the sink thread, only taken when it went idle
+        std::atomic<bool> idle{false};
+        std::mutex mutex;
+        std::condition_variable wake;
+
+        std::thread worker;
+    };
+
+    void run(Priority priority);
+
+    // Append a chunk to its open body
+    void merge(Body& body, Chunk& chunk);
+
+    // Submit an open body of destination; may block while the queue of its class is full
+    void flush(Destination& destination, Body& body, Priority priority);
+
+    Lane lanes[PRIORITY_CLASSES];
+
+    std::mutex destinationsMutex;
+    std::unordered_map<std::string, std::shared_ptr<Destination>> destinations;
+    BatchPolicy policy_ = BatchPolicy::coalesce();
+    std::atomic<std::uint64_t> nextOrigin{0};
+};
+
+#endif // SHAREDSINK_HPP
@@ -0,0 +1,29 @@
+#ifndef TIMESERIES_HPP
+#define TIMESERIES_HPP
+
+#include "Common.hpp"
+
+// Columnar time series: one contiguous time column and one value column,
+// kept in ascending time order with at most one sample per time
+struct TimeSeries {
+    std::vector<double> times;
+    std::vector<double> values;
+
+    // Getters
+    std::size_t size() const { return times.size(); }
+    bool empty() const { return times.empty(); }
+
+    // Append count samples, returns how many existing samples were replaced.
+    // Appending a strictly ascending range past the last time is a plain bulk copy;
+    // anything else is merged so that the later sample wins at equal times.
+    std::size_t append(const double* new_times, const double* new_values, std::size_t count);
+
+    // Remove the samples at or before time; returns how many were removed
+    std::size_t dropThrough(double time);
+
+    // Utility Methods
+    void reserve(std::size_t count);
+    void clear();
+};
+
+#endif // TIMESERIES_HPP
@@ -0,0 +1,59 @@
+#ifndef WORKSTEALINGPOOL_HPP
+#define WORKSTEALINGPOOL_HPP
+
+#include "Common.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// Fixed pool of workers for many small independent tasks. Every worker owns a deque: new
+// tasks are dealt round-robin, a worker takes its own tasks in submission order and, once its
+// deque is empty, steals from the far end of another worker's deque, so slow tasks (a large
+// file, a slow share) never leave the other workers idle.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(int workers);
+    ~WorkStealingPool(); // Runs the queued tasks, then joins the workers
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(Task task);
+
+    // Block until every submitted task ran; rethrows the first exception a task threw
+    void wait();
+
+    // Getters
+    int workerCount() const { return static_cast<int>(workers.size()); }
+    std::uint64_t stolenCount() const { return stolen.load(); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(std::size_t self);
+    bool popOwn(std::size_t self, Task& task);
+    bool steal(std::size_t self, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> nextQueue{0};
+    std::atomic<std::uint64_t> stolen{0};
+
+    // Sleep/wake of idle workers and of wait()
+    std::mutex mutex;
+    std::condition_variable work;
+    std::condition_variable idle;
+    std::size_t queued = 0;  // Submitted and not taken by a worker yet
+    std::size_t pending = 0; // Submitted and not finished
+    bool stopping = false;
+    std::exception_ptr error;
+};
+
+#endif // WORKSTEALINGPOOL_HPP
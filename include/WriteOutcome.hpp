@@ -0,0 +1,35 @@
+#ifndef WRITEOUTCOME_HPP
+#define WRITEOUTCOME_HPP
+
+#include "Common.hpp"
+
+// What an InfluxDB write response says about the lines of its body
+struct WriteOutcome {
+    enum class Kind {
+        Accepted,      // Every line was written
+        PartialWrite,  // Server wrote the good lines and dropped the rest; nothing to resend
+        RejectedLines, // Nothing was written; badLines failed, the others may be resent
+        RejectedBody,  // Nothing was written and the bad lines are unknown; bisect to find them
+        Retry          // Transport error, server error or throttling; resend all of it later
+    };
+
+    Kind kind = Kind::Accepted;
+    std::vector<std::size_t> badLines; // 0-based, sorted
+    std::string message;
+    long status = 0; // HTTP status, 0 after a transport error
+
+    // Classify a response to a write of body; transport_error is empty when HTTP completed
+    static WriteOutcome classify(const std::string& transport_error, long status,
+                                 const std::string& response, const std::string& body);
+
+    // Split body into the lines listed in bad_lines and all the others
+    static void splitLines(const std::string& body, const std::vector<std::size_t>& bad_lines,
+                           std::string& good, std::string& bad);
+
+    // Split body into two halves at a line boundary; false for a single line
+    static bool bisect(const std::string& body, std::string& first, std::string& second);
+
+    static std::size_t countLines(const std::string& body);
+};
+
+#endif // WRITEOUTCOME_HPP
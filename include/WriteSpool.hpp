@@ -0,0 +1,101 @@
+#ifndef WRITESPOOL_HPP
+#define WRITESPOOL_HPP
+
+#include "Common.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+
+// Disk-backed write-ahead spool between the encoders and InfluxDB. append() durably adds an
+// encoded batch to the current segment file of the spool directory and returns at disk speed.
+// A drain thread hands the records in order to a sink (the asynchronous writer) and
+// remembers how far the server acknowledged them in a cursor file. Segments behind the cursor
+// are deleted. After a restart the drain resumes at the cursor, so batches that were spooled
+// but not acknowledged are sent without reading the source files again.
+//
+// Record layout: u32 payload bytes, u32 crc32 of the payload, then the payload:
+// u32 sensor id count, the ids as i32, the newline-terminated lines.
+class WriteSpool {
+public:
+    // Ships one record; the future holds an error when the write ultimately failed
+    using Sink = std::function<std::future<void>(std::string lines, std::vector<int> sensor_ids)>;
+
+    // Constructors and destructors; opening recovers the records of earlier runs
+    explicit WriteSpool(const std::string& directory, std::size_t segment_bytes = DEFAULT_SEGMENT_BYTES);
+    ~WriteSpool(); // Stops the drain; records not acknowledged yet stay on disk
+
+    // Owns files and a thread, so copies are not allowed
+    WriteSpool(const WriteSpool&) = delete;
+    WriteSpool& operator=(const WriteSpool&) = delete;
+
+    // Add an encoded batch; it is on disk when this returns
+    void append(const std::string& lines, const std::vector<int>& sensor_ids);
+
+    // Start shipping records to sink, at most max_outstanding unacknowledged at a time
+    void startDrain(Sink sink, std::size_t max_outstanding);
+
+    // Wait for the records handed to the sink, then stop shipping
+    void stopDrain();
+
+    // Getters
+    const std::string& directory() const { return directory_; }
+
+    static constexpr std::size_t DEFAULT_SEGMENT_BYTES = 64 * 1024 * 1024;
+
+private:
+    // Position of a record boundary in the spool
+    struct Position {
+        std::uint64_t segment = 0;
+        std::uint64_t offset = 0;
+    };
+
+    struct Record {
+        std::string lines;
+        std::vector<int> sensorIds;
+        Position end;
+    };
+
+    struct Shipment {
+        std::future<void> done;
+        Position end;
+    };
+
+    void drain();
+
+    // Read the record at readAt into record and move past it; false when none before limit
+    bool nextRecord(const Position& limit, Record& record);
+
+    // Records up to position were accepted: persist the cursor and drop finished segments
+    void acknowledge(const Position& position);
+
+    // Cut the last segment after its last whole record (a crash may leave a torn one)
+    void recover();
+    void openTail(std::uint64_t segment);
+
+    std::string segmentPath(std::uint64_t segment) const;
+    std::string cursorPath() const;
+
+    std::string directory_;
+    const std::size_t segmentBytes;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    int tailFd = -1;
+    Position tail;   // End of the last whole record
+    Position acked;  // Everything before was accepted
+
+    // Drain thread only
+    int readFd = -1;
+    Position readAt; // Next record for the sink
+
+    Sink sink;
+    std::size_t maxOutstanding = 1;
+    bool stopping = false;
+    std::thread worker;
+
+    static constexpr std::chrono::seconds RETRY_PAUSE{10};
+};
+
+#endif // WRITESPOOL_HPP
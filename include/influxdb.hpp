@@ -285,6 +285,8 @@ namespace influxdb_cpp {
                 goto END;
             }
 
+            // Receive through a 16 KiB buffer instead of the (often 256-byte) header buffer
+            if(len < 0x4000) header.resize(0x4000);
             iv[0].iov_len = len;
 
 #define _NO_MORE() (len >= static_cast<int>(iv[0].iov_len) && \
@@ -0,0 +1,381 @@
+#include "AsyncWriter.hpp"
+#include "WriteOutcome.hpp"
+#include "RejectLog.hpp"
+
+AsyncWriter::AsyncWriter(const std::string& url, const std::string& token, const std::string& bucket,
+                         int max_in_flight, int gzip_level, CircuitBreaker* breaker, Observer observer)
+    : url(url), bucket(bucket), maxInFlight_(std::max(1, max_in_flight)),
+      maxQueued(2 * static_cast<std::size_t>(std::max(1, max_in_flight))), breaker(breaker),
+      observer(std::move(observer)) {
+    if (gzip_level > 0) {
+        gzip = std::make_unique<GzipCompressor>(gzip_level);
+    }
+    plainHeaders.append("Authorization: Token " + token);
+    gzipHeaders.append("Authorization: Token " + token);
+    gzipHeaders.append("Content-Encoding: gzip");
+
+    CurlSession::share(); // Global init happens before the first handle
+    multi = curl_multi_init();
+    if (!multi) {
+        throw std::runtime_error("Error in AsyncWriter constructor: Failed to initialize cURL multi handle.");
+    }
+    worker = std::thread(&AsyncWriter::run, this);
+}
+
+AsyncWriter::~AsyncWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    curl_multi_wakeup(multi);
+    worker.join();
+
+    for (CURL* handle : idleHandles) {
+        curl_easy_cleanup(handle);
+    }
+    curl_multi_cleanup(multi);
+}
+
+void AsyncWriter::submit(std::string lines, std::string gzipped_body, std::vector<int> sensor_ids,
+                         std::uint64_t origin, int attempts, Priority priority, Callback done) {
+    auto request = std::make_unique<Request>();
+    // One copy of a body is kept: the compressed one when there is one
+    request->gzipped = std::move(gzipped_body);
+    if (request->gzipped.empty()) {
+        request->lines = std::move(lines);
+    }
+    request->source = std::make_unique<BufferBody>(request->gzipped.empty() ? request->lines : request->gzipped);
+    request->completion = std::make_shared<Completion>();
+    request->completion->done = std::move(done);
+    std::sort(sensor_ids.begin(), sensor_ids.end());
+    sensor_ids.erase(std::unique(sensor_ids.begin(), sensor_ids.end()), sensor_ids.end());
+    request->sensorIds = std::move(sensor_ids);
+    request->origin = origin;
+    request->priority = priority;
+    request->attemptsLeft = std::max(1, attempts);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto& queue = pending[static_cast<std::size_t>(priority)];
+        queueSpace.wait(lock, [&] { return queue.size() < maxQueued; });
+        request->seq = nextSeq++;
+        queue.push_back(std::move(request));
+    }
+    curl_multi_wakeup(multi);
+}
+
+void AsyncWriter::settle(std::promise<void>& promise, const std::string& error) {
+    if (error.empty()) {
+        promise.set_value();
+    } else {
+        promise.set_exception(std::make_exception_ptr(
+            std::runtime_error("Failed to write batch data to InfluxDB: " + error)));
+    }
+}
+
+void AsyncWriter::run() {
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping && active.empty() &&
+                std::all_of(std::begin(pending), std::end(pending), [](const auto& queue) { return queue.empty(); })) {
+                break;
+            }
+            dispatch();
+        }
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        bool finished = false;
+        int queued = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi, &queued)) {
+            if (message->msg == CURLMSG_DONE) {
+                finish(message->easy_handle, message->data.result);
+                finished = true;
+            }
+        }
+
+        // Wait for socket activity, a submit() or the next retry; a freed handle is reused at once
+        if (!finished) {
+            curl_multi_poll(multi, nullptr, 0, 100, nullptr);
+        }
+    }
+}
+
+void AsyncWriter::dispatch() {
+    const auto now = std::chrono::steady_clock::now();
+
+    // Handles a class may hold; real-time bodies may use all of them and get the free ones first
+    const std::size_t limits[PRIORITY_CLASSES] = {
+        static_cast<std::size_t>(maxInFlight_),
+        std::max<std::size_t>(1, static_cast<std::size_t>(maxInFlight_ * Scheduler::instance().backfillShare()))
+    };
+
+    bool dequeued = false;
+    bool held = false; // By the breaker; asked again on the next poll
+    for (std::size_t index = 0; index < PRIORITY_CLASSES && !held; ++index) {
+        auto& queue = pending[index];
+
+        // Sensors (per origin) of bodies of this class in flight, or queued ahead of the one
+        // being looked at
+        std::unordered_set<std::uint64_t> blocked;
+        auto block = [&blocked](const Request& request) {
+            for (int id : request.sensorIds) {
+                blocked.insert(orderKey(request.origin, id));
+            }
+        };
+        std::size_t running = 0;
+        for (const auto& entry : active) {
+            if (entry.second->priority == static_cast<Priority>(index)) {
+                block(*entry.second);
+                ++running;
+            }
+        }
+
+        for (auto it = queue.begin(); it != queue.end() && running < limits[index] &&
+                 active.size() < static_cast<std::size_t>(maxInFlight_);) {
+            Request& request = **it;
+            bool ready = request.notBefore <= now;
+            for (std::size_t i = 0; ready && i < request.sensorIds.size(); ++i) {
+                ready = blocked.find(orderKey(request.origin, request.sensorIds[i])) == blocked.end();
+            }
+            if (!ready) {
+                block(request);
+                ++it;
+                continue;
+            }
+            if (breaker && !breaker->allow()) {
+                held = true;
+                break;
+            }
+            std::unique_ptr<Request> next = std::move(*it);
+            it = queue.erase(it);
+            block(*next);
+            start(std::move(next));
+            ++running;
+            dequeued = true;
+        }
+    }
+    if (dequeued) {
+        queueSpace.notify_all();
+    }
+}
+
+void AsyncWriter::start(std::unique_ptr<Request> request) {
+    CURL* handle;
+    if (!idleHandles.empty()) {
+        handle = idleHandles.back();
+        idleHandles.pop_back();
+    } else {
+        handle = curl_easy_init();
+        if (!handle) {
+            complete(*request, "Failed to initialize cURL.");
+            return;
+        }
+    }
+
+    // A reset keeps the live connection and caches, only the options are cleared
+    curl_easy_reset(handle);
+    curl_easy_setopt(handle, CURLOPT_SHARE, CurlSession::share());
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, request->gzipped.empty() ? plainHeaders.get() : gzipHeaders.get());
+    request->source->attach(handle);
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &request->response);
+
+    request->startedAt = std::chrono::steady_clock::now();
+    curl_multi_add_handle(multi, handle);
+    active.emplace(handle, std::move(request));
+}
+
+void AsyncWriter::finish(CURL* handle, CURLcode result) {
+    long status = 0;
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &status);
+    curl_multi_remove_handle(multi, handle);
+    idleHandles.push_back(handle);
+
+    auto it = active.find(handle);
+    std::unique_ptr<Request> request = std::move(it->second);
+    active.erase(it);
+
+    // Only a refusal looks at the lines: a bare 2xx means all of them were written
+    if (result == CURLE_OK && (status / 100 != 2 || !request->response.empty())) {
+        restoreLines(*request);
+    }
+    const WriteOutcome outcome = WriteOutcome::classify(
+        result == CURLE_OK ? "" : curl_easy_strerror(result), status, request->response, request->lines);
+
+    if (breaker) {
+        // Only transport errors, 5xx and 429 say the server is in trouble; a 401 or 404 is retried
+        // but says nothing about its health
+        breaker->record(outcome.kind != WriteOutcome::Kind::Retry ||
+                        (outcome.status != 0 && outcome.status < 500 && outcome.status != 429));
+    }
+    if (observer) {
+        observer(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - request->startedAt), outcome.kind != WriteOutcome::Kind::Retry);
+    }
+
+    if (request->probe && (outcome.kind != WriteOutcome::Kind::Retry || request->attemptsLeft <= 1)) {
+        std::shared_ptr<Probe> probe = std::move(request->probe);
+        --probe->inFlight;
+        if (!probe->resolved && outcome.kind == WriteOutcome::Kind::RejectedBody && outcome.message == probe->message) {
+            // Refused like the body: once its siblings are too, one of the parts is bisected further
+            probe->parked.push_back(std::move(request));
+            if (probe->inFlight == 0) {
+                std::unique_ptr<Request> next = std::move(probe->parked.back());
+                probe->parked.pop_back();
+                split(std::move(next), probe->message, probe);
+            }
+            return;
+        }
+        release(*probe);
+    }
+
+    switch (outcome.kind) {
+        case WriteOutcome::Kind::Accepted:
+            complete(*request);
+            return;
+
+        case WriteOutcome::Kind::PartialWrite:
+            // The server kept the good lines; resending them would only repeat them
+            RejectLog::instance().quarantine(bucket, outcome.message, "");
+            complete(*request);
+            return;
+
+        case WriteOutcome::Kind::RejectedLines: {
+            std::string good, bad;
+            WriteOutcome::splitLines(request->lines, outcome.badLines, good, bad);
+            RejectLog::instance().quarantine(bucket, outcome.message, bad);
+            if (good.empty()) {
+                complete(*request);
+            } else {
+                setLines(*request, std::move(good));
+                requeue(std::move(request), std::chrono::seconds(0));
+            }
+            return;
+        }
+
+        case WriteOutcome::Kind::RejectedBody: {
+            // A body that is too large is refused the same way at any size above the limit
+            std::shared_ptr<Probe> probe;
+            if (request->bisectDepth == 0 && outcome.status != 413) {
+                probe = std::make_shared<Probe>();
+                probe->message = outcome.message;
+            }
+            split(std::move(request), outcome.message, std::move(probe));
+            return;
+        }
+
+        case WriteOutcome::Kind::Retry:
+            if (--request->attemptsLeft > 0) {
+                // Back into its place in the queue, so later bodies of the same sensors keep waiting;
+                // a breaker spaces the attempts out instead of the fixed pause
+                requeue(std::move(request), breaker ? std::chrono::seconds(0) : RETRY_PAUSE);
+            } else {
+                complete(*request, outcome.message);
+            }
+            return;
+    }
+}
+
+void AsyncWriter::split(std::unique_ptr<Request> request, const std::string& message, std::shared_ptr<Probe> probe) {
+    std::string first, second;
+    if (request->bisectDepth >= MAX_BISECT_DEPTH || !WriteOutcome::bisect(request->lines, first, second)) {
+        if (!probe) {
+            RejectLog::instance().quarantine(bucket, message, request->lines);
+            complete(*request);
+            return;
+        }
+        // Every part tried was refused like the body, down to a single line: the request is at fault
+        const std::string error = "request refused as a whole: " + message;
+        complete(*request, error);
+        for (auto& parked : probe->parked) {
+            complete(*parked, error);
+        }
+        probe->parked.clear();
+        return;
+    }
+    // The halves replace the body in its place; each one is resolved on its own
+    auto half = std::make_unique<Request>();
+    half->seq = request->seq;
+    half->sensorIds = request->sensorIds;
+    half->origin = request->origin;
+    half->priority = request->priority;
+    half->attemptsLeft = request->attemptsLeft;
+    half->completion = request->completion;
+    half->bisectDepth = ++request->bisectDepth;
+    if (probe) {
+        request->probe = probe;
+        half->probe = probe;
+        probe->inFlight += 2;
+    }
+    ++request->completion->outstanding;
+    setLines(*request, std::move(first));
+    setLines(*half, std::move(second));
+    requeue(std::move(request), std::chrono::seconds(0));
+    requeue(std::move(half), std::chrono::seconds(0));
+}
+
+void AsyncWriter::release(Probe& probe) {
+    probe.resolved = true;
+    std::vector<std::unique_ptr<Request>> parked = std::move(probe.parked);
+    probe.parked.clear();
+    for (auto& request : parked) {
+        split(std::move(request), probe.message, nullptr);
+    }
+}
+
+void AsyncWriter::setLines(Request& request, std::string lines) {
+    // Parts of a body are compressed again when writes are gzipped; rare, so done on this thread
+    request.gzipped = gzip ? gzip->compress(lines) : std::string();
+    request.lines = request.gzipped.empty() ? std::move(lines) : std::string();
+}
+
+void AsyncWriter::restoreLines(Request& request) {
+    if (request.lines.empty() && !request.gzipped.empty()) {
+        request.lines = GzipCompressor::decompress(request.gzipped);
+    }
+}
+
+void AsyncWriter::requeue(std::unique_ptr<Request> request, std::chrono::steady_clock::duration delay) {
+    if (!request->gzipped.empty()) {
+        request->lines = std::string(); // Lines inflated for a check are not kept while queued
+    }
+    request->source = std::make_unique<BufferBody>(request->gzipped.empty() ? request->lines : request->gzipped);
+    request->response.clear();
+    request->notBefore = std::chrono::steady_clock::now() + delay;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& queue = pending[static_cast<std::size_t>(request->priority)];
+    auto position = std::upper_bound(queue.begin(), queue.end(), request->seq,
+        [](std::uint64_t seq, const std::unique_ptr<Request>& queued) { return seq < queued->seq; });
+    queue.insert(position, std::move(request));
+}
+
+void AsyncWriter::complete(Request& request, const std::string& error) {
+    Completion& completion = *request.completion;
+    if (!error.empty() && completion.error.empty()) {
+        completion.error = error;
+    }
+    if (--completion.outstanding > 0) {
+        return;
+    }
+    if (completion.done) {
+        completion.done(completion.error);
+    }
+}
+
+size_t AsyncWriter::WriteCallback(void* contents, size_t size, size_t nmemb, std::string* s) {
+    size_t newLength = size * nmemb;
+    try {
+        s->append((char*)contents, newLength);
+    } catch (std::bad_alloc& e) {
+        // Handle memory problem
+        return 0;
+    }
+    return newLength;
+}
@@ -128,16 +128,17 @@ std::string AzureDatabase::convertDoubleToDateTime(double excelDays) {
 }
 
 // copy from EpitrendBinaryData into SQL table
-bool AzureDatabase::copyToSQL(const std::string& tableName, EpitrendBinaryData data) {
+bool AzureDatabase::copyToSQL(const std::string& tableName, const EpitrendBinaryData& data) {
     if (!isConnected) {
         std::cerr << "No active database connection. Please connect first." << std::endl;
         return false;
     }
 
-    auto allData = data.getAllTimeSeriesData();
-
-    for (const auto& [name, timeSeries] : allData) {
-        for (const auto& [time, value] : timeSeries) {
+    for (const auto& series : data.getAllSeries()) {
+        const std::string& name = series.name;
+        for (std::size_t i = 0; i < series.samples.size(); ++i) {
+            const double time = series.samples.times[i];
+            const double value = series.samples.values[i];
             // Convert double time to DATETIME2 format
             std::time_t rawTime = static_cast<std::time_t>((time - 25569.0) * 86400); // Excel Epoch = 1899-12-30
             std::tm* tmTime = std::gmtime(&rawTime);
@@ -0,0 +1,82 @@
+#include "Batcher.hpp"
+
+BatchPolicy BatchPolicy::backfill() {
+    BatchPolicy policy;
+    policy.maxLines = 50000;
+    policy.maxBytes = 4 * 1024 * 1024;
+    return policy;
+}
+
+BatchPolicy BatchPolicy::realTime() {
+    BatchPolicy policy;
+    policy.maxLines = 2000;
+    policy.maxBytes = 128 * 1024;
+    policy.maxLinger = std::chrono::milliseconds(1000);
+    policy.targetLatency = std::chrono::milliseconds(250);
+    return policy;
+}
+
+BatchPolicy BatchPolicy::coalesce() {
+    BatchPolicy policy;
+    policy.maxLines = 0;
+    policy.maxBytes = 4 * 1024 * 1024;
+    return policy;
+}
+
+Batcher::Batcher(const BatchPolicy& policy) : policy_(policy), lineLimit_(policy.maxLines), byteLimit_(policy.maxBytes) {}
+
+bool Batcher::full(std::size_t lines, std::size_t bytes) {
+    if (lines == 0) {
+        return false;
+    }
+    if (overLimit(lines, bytes)) {
+        return true;
+    }
+    if (policy_.maxLinger.count() > 0) {
+        const auto now = std::chrono::steady_clock::now();
+        if (!open) {
+            open = true;
+            openedAt = now;
+        }
+        return now - openedAt >= policy_.maxLinger;
+    }
+    return false;
+}
+
+bool Batcher::overLimit(std::size_t lines, std::size_t bytes) const {
+    const std::size_t line_limit = lineLimit_;
+    const std::size_t byte_limit = byteLimit_;
+    return (line_limit > 0 && lines >= line_limit) || (byte_limit > 0 && bytes >= byte_limit);
+}
+
+void Batcher::record(std::chrono::milliseconds latency, bool ok) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!policy_.adaptive) {
+        return;
+    }
+    if (!ok) {
+        scale *= 0.5;
+    } else if (latency < policy_.targetLatency) {
+        scale *= 1.25;
+    } else if (latency > 2 * policy_.targetLatency) {
+        scale *= 0.8;
+    }
+    scale = std::clamp(scale, policy_.minScale, policy_.maxScale);
+    applyScale();
+}
+
+void Batcher::setPolicy(const BatchPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    policy_ = policy;
+    scale = 1.0;
+    open = false;
+    applyScale();
+}
+
+void Batcher::applyScale() {
+    // A zero limit stays unchecked; a scaled one never drops below one line or byte
+    lineLimit_ = policy_.maxLines == 0 ? 0 :
+        std::max<std::size_t>(1, static_cast<std::size_t>(static_cast<double>(policy_.maxLines) * scale));
+    byteLimit_ = policy_.maxBytes == 0 ? 0 :
+        std::max<std::size_t>(1, static_cast<std::size_t>(static_cast<double>(policy_.maxBytes) * scale));
+}
@@ -0,0 +1,89 @@
+#include "CircuitBreaker.hpp"
+
+CircuitBreaker& CircuitBreaker::forSink(const std::string& sink) {
+    static std::mutex registry_mutex;
+    static std::unordered_map<std::string, std::unique_ptr<CircuitBreaker>> registry;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    std::unique_ptr<CircuitBreaker>& breaker = registry[sink];
+    if (!breaker) {
+        breaker.reset(new CircuitBreaker(sink));
+    }
+    return *breaker;
+}
+
+CircuitBreaker::CircuitBreaker(const std::string& sink)
+    : sink_(sink), retryAt_(std::chrono::steady_clock::now()),
+      jitter(static_cast<std::minstd_rand::result_type>(std::hash<std::string>()(sink))) {}
+
+bool CircuitBreaker::allow() {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto now = std::chrono::steady_clock::now();
+    if (now < retryAt_) {
+        return false;
+    }
+    if (state_ != State::Closed) {
+        // This caller is the probe; a lost probe only costs one more delay
+        state_ = State::HalfOpen;
+        retryAt_ = now + backoff();
+    }
+    return true;
+}
+
+void CircuitBreaker::wait() {
+    while (!allow()) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait_until(lock, retryAt_);
+    }
+}
+
+void CircuitBreaker::record(bool ok) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto now = std::chrono::steady_clock::now();
+    if (ok) {
+        if (state_ != State::Closed || failures > 0) {
+            std::cout << "CircuitBreaker: " << sink_ << " is healthy again after " << failures << " failures\n";
+        }
+        state_ = State::Closed;
+        failures = 0;
+        retryAt_ = now;
+        changed.notify_all();
+        return;
+    }
+
+    ++failures;
+    if (state_ == State::Closed && failures >= policy_.failureThreshold) {
+        std::cout << "CircuitBreaker: " << sink_ << " failed " << failures << " times in a row, opening circuit\n";
+    }
+    if (failures >= policy_.failureThreshold) {
+        state_ = State::Open;
+    }
+    retryAt_ = std::max(retryAt_, now + backoff());
+}
+
+void CircuitBreaker::setPolicy(const BreakerPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    policy_ = policy;
+}
+
+CircuitBreaker::State CircuitBreaker::state() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return state_;
+}
+
+std::chrono::steady_clock::time_point CircuitBreaker::retryAt() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return retryAt_;
+}
+
+std::chrono::milliseconds CircuitBreaker::backoff() {
+    if (failures == 0) {
+        return std::chrono::milliseconds(0);
+    }
+    // baseDelay * 2^(failures - 1), capped, then a random point in its upper half
+    const int doublings = std::min(failures - 1, 30);
+    const auto ceiling = std::min<long long>(policy_.maxDelay.count(),
+        static_cast<long long>(policy_.baseDelay.count()) << doublings);
+    std::uniform_int_distribution<long long> pick(ceiling / 2, std::max<long long>(ceiling / 2, ceiling));
+    return std::chrono::milliseconds(pick(jitter));
+}
@@ -1,7 +1,11 @@
 #include "Config.hpp"
 
+#include <filesystem>
+#include <thread>
+
 Config::Config(const std::string& configFilePath) {
     loadConfig(configFilePath);
+    prepareOutputPaths();
 }
 
 // Helper function to convert non-visible characters to their visible representations
@@ -69,6 +73,37 @@ void Config::loadConfig(const std::string& configFilePath) {
     configFile.close();
 }
 
+// Create the directories the output files go to, so a missing one fails here instead of at
+// the first write of a file deep in an ingest thread
+void Config::prepareOutputPaths() const {
+    if (configMap.find("OUTPUT_DIR") == configMap.end()) {
+        throw std::runtime_error("Error in Config::prepareOutputPaths call: OUTPUT_DIR is missing from the config file");
+    }
+    std::vector<std::pair<std::string, std::filesystem::path>> directories = {
+        {"OUTPUT_DIR", getOutputDir()},
+        {"SENSOR_REGISTRY_FILE", std::filesystem::path(getSensorRegistryFile()).parent_path()},
+        {"REJECT_FILE", std::filesystem::path(getRejectFile()).parent_path()},
+        {"EPITREND_INDEX_FILE", std::filesystem::path(getEpitrendIndexFile()).parent_path()},
+        {"RGA_INDEX_FILE", std::filesystem::path(getRGAIndexFile()).parent_path()},
+        {"LEDGER_FILE", std::filesystem::path(getLedgerFile()).parent_path()}
+    };
+    if (getInfluxSpool()) {
+        directories.emplace_back("SPOOL_DIR", getSpoolDir());
+    }
+
+    for (const auto& [key, directory] : directories) {
+        if (directory.empty()) {
+            continue; // Relative to the working directory
+        }
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error || !std::filesystem::is_directory(directory)) {
+            throw std::runtime_error("Error in Config::prepareOutputPaths call: cannot create directory " + directory.string() +
+                " for " + key + (error ? ": " + error.message() : ": a file is in the way"));
+        }
+    }
+}
+
 std::string Config::getDataDir() const {
     return configMap.at("DATA_DIR");
 }
@@ -119,4 +154,81 @@ std::string Config::getPrecision() const {
 
 std::string Config::getToken() const {
     return configMap.at("TOKEN");
-}
\ No newline at end of file
+}
+
+std::string Config::getSensorRegistryFile() const {
+    return getValueOr("SENSOR_REGISTRY_FILE", getOutputDir() + "sensor_registry.tsv");
+}
+
+std::string Config::getRejectFile() const {
+    return getValueOr("REJECT_FILE", getOutputDir() + "rejected_lines.txt");
+}
+
+std::string Config::getEpitrendIndexFile() const {
+    return getValueOr("EPITREND_INDEX_FILE", getOutputDir() + "epitrend_index.tsv");
+}
+
+std::string Config::getRGAIndexFile() const {
+    return getValueOr("RGA_INDEX_FILE", getOutputDir() + "rga_index.tsv");
+}
+
+std::string Config::getLedgerFile() const {
+    return getValueOr("LEDGER_FILE", getOutputDir() + "ingest_ledger.tsv");
+}
+
+std::string Config::getSpoolDir() const {
+    return getValueOr("SPOOL_DIR", getOutputDir() + "spool/");
+}
+
+bool Config::getInfluxSpool() const {
+    return getValueOr("INFLUX_SPOOL", "0") == "1";
+}
+
+int Config::getInfluxGzipLevel() const {
+    return std::stoi(getValueOr("INFLUX_GZIP_LEVEL", "0"));
+}
+
+int Config::getInfluxMaxInFlight() const {
+    return std::stoi(getValueOr("INFLUX_MAX_IN_FLIGHT", "4"));
+}
+
+int Config::getSchedulerWorkers() const {
+    return std::stoi(getValueOr("SCHEDULER_WORKERS", "3"));
+}
+
+double Config::getBackfillShare() const {
+    return std::stod(getValueOr("BACKFILL_SHARE", "0.5"));
+}
+
+int Config::getBackfillWorkers() const {
+    return std::stoi(getValueOr("BACKFILL_WORKERS", std::to_string(std::max(1u, std::thread::hardware_concurrency()))));
+}
+
+int Config::getBackfillQueueDepth() const {
+    return std::stoi(getValueOr("BACKFILL_QUEUE_DEPTH", std::to_string(2 * getBackfillWorkers())));
+}
+
+int Config::getEncoderWorkers() const {
+    return std::stoi(getValueOr("ENCODER_WORKERS", "2"));
+}
+
+int Config::getSenderWorkers() const {
+    return std::stoi(getValueOr("SENDER_WORKERS", "2"));
+}
+
+int Config::getPipelineQueueDepth() const {
+    return std::stoi(getValueOr("PIPELINE_QUEUE_DEPTH", "4"));
+}
+
+int Config::getReadAheadThreads() const {
+    return std::stoi(getValueOr("READ_AHEAD_THREADS", "4"));
+}
+
+int Config::getReadAheadFiles() const {
+    return std::stoi(getValueOr("READ_AHEAD_FILES", std::to_string(4 * getBackfillWorkers())));
+}
+
+std::string Config::getValueOr(const std::string& key, const std::string& default_value) const {
+    auto it = configMap.find(key);
+    return (it == configMap.end() || it->second.empty()) ? default_value : it->second;
+}
@@ -0,0 +1,121 @@
+#include "CurlSession.hpp"
+
+#include <mutex>
+
+void CurlHeaders::append(const std::string& header) {
+    headers_ = curl_slist_append(headers_, header.c_str());
+    if (!headers_) {
+        throw std::runtime_error("Failed to append header.");
+    }
+}
+
+//=============================END OF CURLHEADERS CLASS METHODS==============================
+
+namespace {
+
+// Process-wide curl state: global init plus the share handle and the locks it asks for
+struct SharedCurl {
+    CURLSH* handle = nullptr;
+    std::mutex locks[CURL_LOCK_DATA_LAST];
+
+    SharedCurl() {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+        handle = curl_share_init();
+        if (!handle) {
+            throw std::runtime_error("Error in CurlSession::share call: Failed to initialize cURL share handle.");
+        }
+        curl_share_setopt(handle, CURLSHOPT_LOCKFUNC, lock);
+        curl_share_setopt(handle, CURLSHOPT_UNLOCKFUNC, unlock);
+        curl_share_setopt(handle, CURLSHOPT_USERDATA, this);
+        // Connections stay with their handle: libcurl does not support one connection cache
+        // used by handles on different threads at once
+        curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    static void lock(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+        static_cast<SharedCurl*>(userptr)->locks[data].lock();
+    }
+
+    static void unlock(CURL*, curl_lock_data data, void* userptr) {
+        static_cast<SharedCurl*>(userptr)->locks[data].unlock();
+    }
+};
+
+} // namespace
+
+CURLSH* CurlSession::share() {
+    // Never cleaned up: easy handles of other threads may outlive any static destructor
+    static SharedCurl* shared = new SharedCurl();
+    return shared->handle;
+}
+
+CurlSession::CurlSession() {
+    share(); // Global init happens before the first easy handle
+    handle = curl_easy_init();
+    if (!handle) {
+        throw std::runtime_error("Failed to initialize cURL.");
+    }
+}
+
+CurlSession::~CurlSession() {
+    curl_easy_cleanup(handle);
+}
+
+long CurlSession::post(const std::string& url, const CurlHeaders& headers,
+                       RequestBody& body, std::string& response) {
+    prepare(url, headers, response);
+    body.attach(handle);
+    return perform(url);
+}
+
+long CurlSession::post(const std::string& url, const CurlHeaders& headers,
+                       const char* body, std::size_t length, std::string& response) {
+    BufferBody source(body, length);
+    return post(url, headers, source, response);
+}
+
+long CurlSession::get(const std::string& url, const CurlHeaders& headers, std::string& response) {
+    prepare(url, headers, response);
+    curl_easy_setopt(handle, CURLOPT_HTTPGET, 1L);
+    return perform(url);
+}
+
+void CurlSession::prepare(const std::string& url, const CurlHeaders& headers, std::string& response) {
+    // A reset keeps the live connection and caches, only the options are cleared
+    curl_easy_reset(handle);
+    curl_easy_setopt(handle, CURLOPT_SHARE, share());
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers.get());
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &response);
+}
+
+long CurlSession::perform(const std::string& url) {
+    CURLcode res = curl_easy_perform(handle);
+    if (res != CURLE_OK) {
+        if (breaker_) {
+            breaker_->record(false);
+        }
+        throw std::runtime_error("cURL request to " + url + " failed: " + std::string(curl_easy_strerror(res)));
+    }
+    long status = 0;
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &status);
+    if (breaker_) {
+        breaker_->record(status < 500 && status != 429);
+    }
+    return status;
+}
+
+size_t CurlSession::WriteCallback(void* contents, size_t size, size_t nmemb, std::string* s) {
+    size_t newLength = size * nmemb;
+    try {
+        s->append((char*)contents, newLength);
+    } catch (std::bad_alloc& e) {
+        // Handle memory problem
+        return 0;
+    }
+    return newLength;
+}
@@ -0,0 +1,133 @@
+#include "DeltaTracker.hpp"
+
+#include <iterator>
+
+DeltaTracker::DeltaTracker(double late_window) : lateWindow(late_window) {
+    if (late_window < 0.0) {
+        throw std::invalid_argument("Error in DeltaTracker constructor: late window must not be negative");
+    }
+}
+
+std::size_t DeltaTracker::delta(const EpitrendBinaryData& current, EpitrendBinaryData& out) const {
+    std::size_t count = 0;
+    std::vector<double> times, values;
+    for (const auto& series : current.getAllSeries()) {
+        auto it = epitrendMarks.find(series.name);
+        const Mark* mark = it == epitrendMarks.end() ? nullptr : &it->second;
+
+        bool all_new = false;
+        std::size_t first = firstCandidate(mark, series.samples, all_new);
+        if (all_new) {
+            // The new samples are a suffix of the series, so append them in place
+            std::size_t n = series.samples.size() - first;
+            out.appendRange(series.name, series.samples.times.data() + first, series.samples.values.data() + first, n);
+            count += n;
+            continue;
+        }
+        gatherNew(*mark, series.samples, first, times, values);
+        out.appendRange(series.name, times, values);
+        count += times.size();
+    }
+    return count;
+}
+
+std::size_t DeltaTracker::delta(const RGAData& current, RGAData& out) const {
+    std::size_t count = 0;
+    std::vector<double> times, values;
+    for (const auto& series : current.getAllSeries()) {
+        auto it = rgaMarks.find(series.id);
+        const Mark* mark = it == rgaMarks.end() ? nullptr : &it->second;
+
+        bool all_new = false;
+        std::size_t first = firstCandidate(mark, series.samples, all_new);
+        if (all_new) {
+            // The new samples are a suffix of the series, so append them in place
+            std::size_t n = series.samples.size() - first;
+            out.appendRange(series.id, series.samples.times.data() + first, series.samples.values.data() + first, n);
+            count += n;
+            continue;
+        }
+        gatherNew(*mark, series.samples, first, times, values);
+        out.appendRange(series.id, times.data(), values.data(), times.size());
+        count += times.size();
+    }
+    return count;
+}
+
+void DeltaTracker::commit(const EpitrendBinaryData& sent) {
+    for (const auto& series : sent.getAllSeries()) {
+        if (!series.samples.empty()) {
+            advance(epitrendMarks[series.name], series.samples);
+        }
+    }
+}
+
+void DeltaTracker::commit(const RGAData& sent) {
+    for (const auto& series : sent.getAllSeries()) {
+        if (!series.samples.empty()) {
+            advance(rgaMarks[series.id], series.samples);
+        }
+    }
+}
+
+void DeltaTracker::clear() {
+    epitrendMarks.clear();
+    rgaMarks.clear();
+}
+
+// Internal search for the first sample that may be new; the times of a series are sorted
+std::size_t DeltaTracker::firstCandidate(const Mark* mark, const TimeSeries& samples, bool& all_new) const {
+    if (!mark) {
+        all_new = true;
+        return 0;
+    }
+    const std::vector<double>& times = samples.times;
+    std::size_t past_mark = static_cast<std::size_t>(
+        std::upper_bound(times.begin(), times.end(), mark->highWater) - times.begin());
+    if (lateWindow <= 0.0) {
+        all_new = true;
+        return past_mark;
+    }
+    std::size_t in_window = static_cast<std::size_t>(
+        std::upper_bound(times.begin(), times.begin() + past_mark, mark->highWater - lateWindow) - times.begin());
+    all_new = in_window == past_mark;
+    return in_window;
+}
+
+// Internal gather of the new samples, skipping late ones whose time was already sent
+void DeltaTracker::gatherNew(const Mark& mark, const TimeSeries& samples, std::size_t first,
+    std::vector<double>& times, std::vector<double>& values) const {
+    times.clear();
+    values.clear();
+    std::size_t r = 0;
+    for (std::size_t i = first; i < samples.size(); ++i) {
+        double time = samples.times[i];
+        if (time <= mark.highWater) {
+            while (r < mark.recent.size() && mark.recent[r] < time) {
+                ++r;
+            }
+            if (r < mark.recent.size() && mark.recent[r] == time) {
+                continue; // Already sent
+            }
+        }
+        times.push_back(time);
+        values.push_back(samples.values[i]);
+    }
+}
+
+// Internal advance of a mark past the sorted times of samples
+void DeltaTracker::advance(Mark& mark, const TimeSeries& samples) {
+    mark.highWater = std::max(mark.highWater, samples.times.back());
+    if (lateWindow <= 0.0) {
+        return;
+    }
+
+    // Keep only the sent times that are still inside the late window
+    const double window_start = mark.highWater - lateWindow;
+    auto sent_begin = std::upper_bound(samples.times.begin(), samples.times.end(), window_start);
+    auto recent_begin = std::upper_bound(mark.recent.begin(), mark.recent.end(), window_start);
+    std::vector<double> recent;
+    recent.reserve(static_cast<std::size_t>((mark.recent.end() - recent_begin) + (samples.times.end() - sent_begin)));
+    std::set_union(recent_begin, mark.recent.end(), sent_begin, samples.times.end(), std::back_inserter(recent));
+    mark.recent.swap(recent);
+}
@@ -1,97 +1,130 @@
 #include "EpitrendBinaryData.hpp"
 
 // Setters
-void EpitrendBinaryData::addDataItem( std::string name, 
-    std::pair<double,double> time_series, 
+void EpitrendBinaryData::addDataItem(const std::string& name,
+    std::pair<double,double> time_series,
     bool verbose
-) { 
-    // Check if name already exists in map
-    if (allTimeSeriesData.find(name) == allTimeSeriesData.end()) {
-        // Key does not exist so add name and time-series data
-        allTimeSeriesData[name][time_series.first]= time_series.second;
-
-    } else {
-        // Key exists so append to the time-series data
-        // Check if any time-data already exists for the name
-        if (allTimeSeriesData[name].find(time_series.first) == allTimeSeriesData[name].end()) {
-            // Time-data does not exist for the name so add to the map
-            allTimeSeriesData[name][time_series.first] = time_series.second;
-
-        } else {
-            // Time-data does exist so replace the data but also give out warning (if verbose was given)
-            allTimeSeriesData[name][time_series.first] = time_series.second;
-
-            // Give user a warning
-            if (verbose) {
-                std::cerr << std::setprecision(15) << "Warning in EpitrendBinaryData::addDataItem call: time-series data " << time_series.first << " already exists for " << name << ".\n";
-                
-            }
-        
-        }
-    
+) {
+    appendRange(name, &time_series.first, &time_series.second, 1, verbose);
+}
+
+void EpitrendBinaryData::appendRange(const std::string& name,
+    const double* times,
+    const double* values,
+    std::size_t count,
+    bool verbose
+) {
+    if (count == 0) {
+        return;
+    }
+
+    // Append to the time-series data, replacing any samples at times that already exist
+    Series& series = seriesFor(name);
+    std::size_t replaced = series.samples.append(times, values, count);
+
+    // Give user a warning
+    if (replaced > 0 && verbose) {
+        std::cerr << "Warning in EpitrendBinaryData::appendRange call: " << replaced
+        << " time-series data already existed for " << name << " and was replaced.\n";
     }
 
     // Increment byteSize of object
-    byteSize = byteSize + 16 + name.length(); // 8 bytes * 2 + 1 byte * number of chars
+    byteSize = byteSize + static_cast<int>(count * (16 + name.length())); // 8 bytes * 2 + 1 byte * number of chars
+}
+
+void EpitrendBinaryData::appendRange(const std::string& name,
+    const std::vector<double>& times,
+    const std::vector<double>& values,
+    bool verbose
+) {
+    if (times.size() != values.size()) {
+        throw std::invalid_argument("Error in EpitrendBinaryData::appendRange call: times and values differ in length for " + name);
+    }
+    appendRange(name, times.data(), values.data(), times.size(), verbose);
+}
+
+void EpitrendBinaryData::append(const EpitrendBinaryData& other, bool verbose) {
+    for (const auto& series : other.allSeries) {
+        appendRange(series.name, series.samples.times.data(), series.samples.values.data(), series.samples.size(), verbose);
+    }
+}
+
+void EpitrendBinaryData::dropThrough(double time) {
+    for (auto& series : allSeries) {
+        const std::size_t dropped = series.samples.dropThrough(time);
+        byteSize = byteSize - static_cast<int>(dropped * (16 + series.name.length()));
+    }
 }
 
 // Getters
-std::unordered_map<std::string, std::unordered_map<double,double>> EpitrendBinaryData::getAllTimeSeriesData() {
-    return allTimeSeriesData; 
+const std::vector<EpitrendBinaryData::Series>& EpitrendBinaryData::getAllSeries() const {
+    return allSeries;
+}
+
+const EpitrendBinaryData::Series* EpitrendBinaryData::findSeries(const std::string& name) const {
+    auto it = seriesIndex.find(name);
+    return it == seriesIndex.end() ? nullptr : &allSeries[it->second];
 }
-int EpitrendBinaryData::getByteSize() { return byteSize;}
+
+std::size_t EpitrendBinaryData::getSampleCount() const {
+    std::size_t count = 0;
+    for (const auto& series : allSeries) {
+        count += series.samples.size();
+    }
+    return count;
+}
+
+int EpitrendBinaryData::getByteSize() const { return byteSize;}
 
 // Utility
-void EpitrendBinaryData::printAllTimeSeriesData(){
-        for(auto element : allTimeSeriesData){
-            std::cout << element.first << "\n";
-            
-            for(auto inner_element : element.second){
-                std::cout << "  " << inner_element.first << "," << inner_element.second << "\n";
+void EpitrendBinaryData::printAllTimeSeriesData() const {
+        for(const auto& series : allSeries){
+            std::cout << series.name << "\n";
+
+            for(std::size_t i = 0; i < series.samples.size(); ++i){
+                std::cout << "  " << series.samples.times[i] << "," << series.samples.values[i] << "\n";
             }
         }
 }
 
-void EpitrendBinaryData::printFileAllTimeSeriesData(const Config& config, const std::string& filename){
+void EpitrendBinaryData::printFileAllTimeSeriesData(const Config& config, const std::string& filename) const {
     std::string fullpath = config.getOutputDir() + filename;
     std::ofstream outFile(fullpath);
-    for(auto element : allTimeSeriesData) {
-        outFile << element.first << "\n";
-        
-        for(auto inner_element : element.second) {
-            outFile << std::setprecision(15) << inner_element.first << "," << inner_element.second << "\n";
-        
+    for(const auto& series : allSeries) {
+        outFile << series.name << "\n";
+
+        for(std::size_t i = 0; i < series.samples.size(); ++i) {
+            outFile << std::setprecision(15) << series.samples.times[i] << "," << series.samples.values[i] << "\n";
+
         }
 
     }
 }
 
-bool EpitrendBinaryData::is_empty(){
-    return allTimeSeriesData.empty();
+bool EpitrendBinaryData::is_empty() const {
+    // dropThrough() may leave series without samples, so empty means no series holds any data
+    for (const auto& series : allSeries) {
+        if (!series.samples.empty()) {
+            return false;
+        }
+    }
+    return true;
 }
 
 //
 void EpitrendBinaryData::clear(){
-    allTimeSeriesData.clear();
+    allSeries.clear();
+    seriesIndex.clear();
     byteSize = 0;
 }
 
-// Return the difference between two EpitrendBinaryData objects
-EpitrendBinaryData EpitrendBinaryData::difference(EpitrendBinaryData& other) const{
-    std::unordered_map<std::string, std::unordered_map<double,double>> other_data = other.getAllTimeSeriesData();
-    EpitrendBinaryData diff_data;
-    for(auto element : allTimeSeriesData){
-        std::string name = element.first;
-        std::unordered_map<double,double> time_series = element.second;
-        for(auto inner_element : time_series){
-            double time = inner_element.first;
-            double value = inner_element.second;
-            if(other_data.find(name) == other_data.end() || other_data[name].find(time) == other_data[name].end()){
-                diff_data.addDataItem(name, std::make_pair(time, value));
-            }
-        }
+// Internal lookup of the series for name, creating it if needed
+EpitrendBinaryData::Series& EpitrendBinaryData::seriesFor(const std::string& name) {
+    auto it = seriesIndex.find(name);
+    if (it != seriesIndex.end()) {
+        return allSeries[it->second];
     }
-
-    return diff_data;
-    
+    seriesIndex.emplace(name, allSeries.size());
+    allSeries.push_back(Series{name, TimeSeries()});
+    return allSeries.back();
 }
@@ -38,6 +38,10 @@ EpitrendBinaryFormat::DataItem EpitrendBinaryFormat::getDataItem(const std::stri
     }
 }
 
+const std::unordered_map<std::string, EpitrendBinaryFormat::DataItem>& EpitrendBinaryFormat::getDataItems() const {
+    return dataItems;
+}
+
 // Utility Methods
 bool EpitrendBinaryFormat::hasDataItem(const std::string& name) const {
     return dataItems.find(name) != dataItems.end();
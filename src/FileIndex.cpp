@@ -0,0 +1,261 @@
+#include "FileIndex.hpp"
+
+#include <cstdio>
+
+namespace fs = std::filesystem;
+
+FileIndex::FileIndex(Layout layout, const std::string& root, const std::string& index_path)
+    : layout(layout), root(root), indexPath(index_path) {
+    load();
+}
+
+std::size_t FileIndex::refresh(bool verbose) {
+    std::map<std::string, Directory> found;
+    std::size_t listed = 0;
+    if (layout == Layout::Epitrend) {
+        walkEpitrend(found, listed, verbose);
+    } else {
+        walkRGA(found, listed, verbose);
+    }
+
+    // Directories that are gone drop out with their files
+    directories.swap(found);
+    save();
+    if (verbose) {
+        std::cout << "In FileIndex::refresh call: listed " << listed << " of " << directories.size()
+                  << " directories below " << root << ", " << size() << " files indexed\n";
+    }
+    return listed;
+}
+
+std::vector<IndexedFile> FileIndex::files() const {
+    std::vector<IndexedFile> all;
+    all.reserve(size());
+    for (const auto& [path, directory] : directories) {
+        all.insert(all.end(), directory.files.begin(), directory.files.end());
+    }
+    std::sort(all.begin(), all.end(), [](const IndexedFile& lhs, const IndexedFile& rhs) {
+        const auto lhs_time = std::make_tuple(lhs.year, lhs.month, lhs.day, lhs.hour);
+        const auto rhs_time = std::make_tuple(rhs.year, rhs.month, rhs.day, rhs.hour);
+        return lhs_time != rhs_time ? lhs_time > rhs_time : lhs.GM < rhs.GM;
+    });
+    return all;
+}
+
+std::size_t FileIndex::size() const {
+    std::size_t count = 0;
+    for (const auto& [path, directory] : directories) {
+        count += directory.files.size();
+    }
+    return count;
+}
+
+// Internal walk of <root><GM> Molly/EpiTrend/EpiTrendData/<yyyy>/<mm>-<Mon>/
+void FileIndex::walkEpitrend(std::map<std::string, Directory>& found, std::size_t& listed, bool verbose) {
+    const std::string suffix = " Molly";
+    std::error_code error;
+    for (const auto& machine : fs::directory_iterator(root, error)) {
+        const std::string machine_name = machine.path().filename().string();
+        if (!machine.is_directory() || machine_name.size() <= suffix.size() ||
+            machine_name.compare(machine_name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            continue;
+        }
+        const std::string GM = machine_name.substr(0, machine_name.size() - suffix.size());
+        const fs::path data_dir = machine.path() / "EpiTrend" / "EpiTrendData";
+
+        for (const auto& year_dir : fs::directory_iterator(data_dir, error)) {
+            int year = 0;
+            if (!year_dir.is_directory() || std::sscanf(year_dir.path().filename().c_str(), "%4d", &year) != 1) {
+                continue;
+            }
+            for (const auto& month_dir : fs::directory_iterator(year_dir.path(), error)) {
+                int month = 0;
+                if (!month_dir.is_directory() || std::sscanf(month_dir.path().filename().c_str(), "%2d-", &month) != 1) {
+                    continue;
+                }
+
+                listLeaf(month_dir.path(), [&](const fs::path& directory, Directory& entry) {
+                    // A data file only counts when its format file is next to it
+                    std::set<std::string> names;
+                    for (const auto& file : fs::directory_iterator(directory, error)) {
+                        names.insert(file.path().filename().string());
+                    }
+                    for (const std::string& name : names) {
+                        int day = 0, hour = 0, consumed = 0;
+                        if (std::sscanf(name.c_str(), "%2dday-%2dhr-binary.txt%n", &day, &hour, &consumed) != 2 ||
+                            consumed != static_cast<int>(name.size()) ||
+                            !names.count(name.substr(0, name.size() - std::string("-binary.txt").size()) + ".txt")) {
+                            continue;
+                        }
+                        IndexedFile indexed;
+                        indexed.GM = GM;
+                        indexed.year = year;
+                        indexed.month = month;
+                        indexed.day = day;
+                        indexed.hour = hour;
+                        indexed.path = (directory / name).string();
+                        indexed.size = fs::file_size(indexed.path, error);
+                        indexed.mtime = mtimeOf(indexed.path);
+                        entry.files.push_back(std::move(indexed));
+                    }
+                }, found, listed, verbose);
+            }
+        }
+    }
+    if (error && verbose) {
+        std::cerr << "Warning in FileIndex::walkEpitrend call: " << error.message() << "\n";
+    }
+}
+
+// Internal walk of <root><yyyy>-<mmm>-<dd>/
+void FileIndex::walkRGA(std::map<std::string, Directory>& found, std::size_t& listed, bool verbose) {
+    const std::string prefix = "daily log, ";
+    const std::string marker = ", RGA MPH ";
+    std::error_code error;
+    for (const auto& day_dir : fs::directory_iterator(root, error)) {
+        int year = 0, month = 0, day = 0;
+        if (!day_dir.is_directory() || std::sscanf(day_dir.path().filename().c_str(), "%4d-%3d-%2d", &year, &month, &day) != 3) {
+            continue;
+        }
+
+        listLeaf(day_dir.path(), [&](const fs::path& directory, Directory& entry) {
+            // The first log of a GM in name order, one per GM and day
+            std::set<std::string> GMs;
+            std::set<std::string> names;
+            for (const auto& file : fs::directory_iterator(directory, error)) {
+                if (file.is_regular_file()) {
+                    names.insert(file.path().filename().string());
+                }
+            }
+            for (const std::string& name : names) {
+                const std::size_t marker_pos = name.find(marker);
+                if (name.compare(0, prefix.size(), prefix) != 0 || marker_pos == std::string::npos ||
+                    name.size() < 4 || name.compare(name.size() - 4, 4, ".dat") != 0) {
+                    continue;
+                }
+                const std::string GM = name.substr(prefix.size(), marker_pos - prefix.size());
+                if (!GMs.insert(GM).second) {
+                    continue;
+                }
+                IndexedFile indexed;
+                indexed.GM = GM;
+                indexed.year = year;
+                indexed.month = month;
+                indexed.day = day;
+                indexed.path = (directory / name).string();
+                indexed.size = fs::file_size(indexed.path, error);
+                indexed.mtime = mtimeOf(indexed.path);
+                entry.files.push_back(std::move(indexed));
+            }
+        }, found, listed, verbose);
+    }
+    if (error && verbose) {
+        std::cerr << "Warning in FileIndex::walkRGA call: " << error.message() << "\n";
+    }
+}
+
+void FileIndex::listLeaf(const fs::path& directory,
+                         const std::function<void(const fs::path&, Directory&)>& parse,
+                         std::map<std::string, Directory>& found, std::size_t& listed, bool verbose) {
+    const std::string key = directory.string();
+    const std::int64_t mtime = mtimeOf(directory);
+    auto known = directories.find(key);
+    if (known != directories.end() && known->second.mtime == mtime) {
+        found[key] = std::move(known->second);
+        return;
+    }
+
+    if (verbose) {
+        std::cout << "In FileIndex::refresh call: listing " << key << "\n";
+    }
+    Directory& entry = found[key];
+    entry.mtime = mtime;
+    parse(directory, entry);
+    ++listed;
+}
+
+std::int64_t FileIndex::mtimeOf(const fs::path& path) {
+    std::error_code error;
+    const auto time = fs::last_write_time(path, error);
+    return error ? 0 : static_cast<std::int64_t>(time.time_since_epoch().count());
+}
+
+// Internal load of the saved index: a D line per leaf directory, then an F line per file in it
+//   D <mtime> <directory>
+//   F <GM> <year> <month> <day> <hour> <size> <mtime> <file name>
+void FileIndex::load() {
+    std::ifstream file(indexPath);
+    if (!file.is_open()) {
+        return;
+    }
+    std::string line;
+    Directory* directory = nullptr;
+    std::string directory_path;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string type;
+        std::getline(fields, type, '\t');
+        if (type == "D") {
+            std::string mtime;
+            std::getline(fields, mtime, '\t');
+            std::getline(fields, directory_path);
+            if (directory_path.empty()) {
+                directory = nullptr;
+                continue;
+            }
+            directory = &directories[directory_path];
+            directory->mtime = std::stoll(mtime);
+        } else if (type == "F" && directory) {
+            IndexedFile indexed;
+            std::string year, month, day, hour, size, mtime, name;
+            std::getline(fields, indexed.GM, '\t');
+            std::getline(fields, year, '\t');
+            std::getline(fields, month, '\t');
+            std::getline(fields, day, '\t');
+            std::getline(fields, hour, '\t');
+            std::getline(fields, size, '\t');
+            std::getline(fields, mtime, '\t');
+            std::getline(fields, name);
+            try {
+                indexed.year = std::stoi(year);
+                indexed.month = std::stoi(month);
+                indexed.day = std::stoi(day);
+                indexed.hour = std::stoi(hour);
+                indexed.size = std::stoull(size);
+                indexed.mtime = std::stoll(mtime);
+            } catch (const std::exception&) {
+                // A torn line forces a new listing of its directory
+                std::cerr << "Warning in FileIndex::load call: skipping malformed line in " << indexPath << "\n";
+                directory->mtime = 0;
+                continue;
+            }
+            indexed.path = (fs::path(directory_path) / name).string();
+            directory->files.push_back(std::move(indexed));
+        }
+    }
+}
+
+// Internal save; replaced in one rename, so a crash leaves the previous index
+void FileIndex::save() const {
+    const std::string temporary = indexPath + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Warning in FileIndex::save call: Could not open file: " << temporary << "\n";
+            return;
+        }
+        for (const auto& [path, directory] : directories) {
+            file << "D\t" << directory.mtime << "\t" << path << "\n";
+            for (const IndexedFile& indexed : directory.files) {
+                file << "F\t" << indexed.GM << "\t" << indexed.year << "\t" << indexed.month << "\t" << indexed.day
+                     << "\t" << indexed.hour << "\t" << indexed.size << "\t" << indexed.mtime
+                     << "\t" << fs::path(indexed.path).filename().string() << "\n";
+            }
+        }
+    }
+    std::error_code error;
+    fs::rename(temporary, indexPath, error);
+    if (error) {
+        std::cerr << "Warning in FileIndex::save call: Could not replace " << indexPath << ": " << error.message() << "\n";
+    }
+}
@@ -0,0 +1,150 @@
+#include "FileLoader.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FileLoader::FileLoader(std::vector<std::string> paths, int threads, std::size_t depth)
+    : depth(depth), order(std::move(paths)) {
+    if (threads < 1 || depth < 1) {
+        throw std::invalid_argument("Error in FileLoader::FileLoader call: need at least one thread and one file ahead, got " +
+            std::to_string(threads) + " and " + std::to_string(depth));
+    }
+    for (const std::string& path : order) {
+        entries.try_emplace(path);
+    }
+    for (int i = 0; i < threads; ++i) {
+        this->threads.emplace_back(&FileLoader::work, this);
+    }
+}
+
+FileLoader::~FileLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+std::string FileLoader::take(const std::string& path) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = entries.find(path);
+    if (it != entries.end()) {
+        Entry& entry = it->second;
+        changed.wait(lock, [&entry] { return entry.state != State::Loading; });
+        if (entry.state == State::Ready || entry.state == State::Failed) {
+            const bool failed = entry.state == State::Failed;
+            std::string bytes = std::move(entry.bytes);
+            std::string error = std::move(entry.error);
+            entry.state = State::Taken;
+            --ahead;
+            ++hits;
+            changed.notify_all();
+            if (failed) {
+                throw std::runtime_error(error);
+            }
+            return bytes;
+        }
+        // Not read yet: the loader threads skip it from now on
+        entry.state = State::Taken;
+    }
+    ++misses;
+    lock.unlock();
+    return readFile(path);
+}
+
+void FileLoader::discard(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(path);
+    if (it == entries.end()) {
+        return;
+    }
+    Entry& entry = it->second;
+    if (entry.state == State::Ready || entry.state == State::Failed) {
+        entry.bytes = std::string();
+        entry.error.clear();
+        --ahead;
+        changed.notify_all();
+    }
+    // A file being read is let go by its loader thread
+    entry.state = State::Taken;
+}
+
+std::string FileLoader::readFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Error in FileLoader::readFile call: Could not open file: " + path);
+    }
+
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Error in FileLoader::readFile call: Could not stat file: " + path);
+    }
+
+    // The whole file is read front to back, so ask for all of it at once
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+
+    std::string bytes(static_cast<std::size_t>(file_stat.st_size), '\0');
+    std::size_t done = 0;
+    while (done < bytes.size()) {
+        const ssize_t count = ::pread(fd, &bytes[done], bytes.size() - done, static_cast<off_t>(done));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            ::close(fd);
+            throw std::runtime_error("Error in FileLoader::readFile call: Could not read file: " + path);
+        }
+        if (count == 0) {
+            break; // Truncated since the stat
+        }
+        done += static_cast<std::size_t>(count);
+    }
+    bytes.resize(done);
+
+    // The bytes are kept by the caller, so the cached pages are not needed again
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+    return bytes;
+}
+
+void FileLoader::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        changed.wait(lock, [this] { return stopping || next >= order.size() || ahead < depth; });
+        if (stopping || next >= order.size()) {
+            return;
+        }
+        Entry& entry = entries.at(order[next]);
+        const std::string& path = order[next++];
+        if (entry.state != State::Queued) {
+            continue; // Taken early or listed twice
+        }
+        entry.state = State::Loading;
+        ++ahead;
+
+        lock.unlock();
+        std::string bytes, error;
+        try {
+            bytes = readFile(path);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        lock.lock();
+
+        if (entry.state == State::Taken) {
+            --ahead; // Discarded while it was read
+        } else {
+            entry.state = error.empty() ? State::Ready : State::Failed;
+            entry.bytes = std::move(bytes);
+            entry.error = std::move(error);
+        }
+        changed.notify_all();
+    }
+}
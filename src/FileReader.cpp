@@ -1,4 +1,7 @@
 #include "FileReader.hpp"
+#include <charconv>
+#include <cstring>
+#include <string_view>
 
 namespace fs = std::filesystem;
 
@@ -11,6 +14,123 @@ std::string FileReader::trimInternal(const std::string& str) {
     return trimmed;
 }
 
+// Decode an Epitrend -binary.txt file in place through a read-only mapping
+void FileReader::decodeEpitrendBinaryDataFile(
+    const EpitrendBinaryFormat& binary_format,
+    const std::string& fullpath,
+    EpitrendBinaryData& binary_data,
+    const std::string& caller,
+    EpitrendWatermarks* watermarks,
+    bool verbose
+) {
+    // Map the file (throws if it cannot be opened)
+    MappedFile file;
+    try {
+        file = MappedFile(fullpath);
+    } catch (const std::exception&) {
+        throw std::runtime_error("Error " + caller + " function call: Could not open file: " + fullpath);
+    }
+
+    decodeEpitrendBinaryData(binary_format, file.data(), file.size(), fullpath, binary_data, caller, watermarks, verbose);
+}
+
+// Internal decoding of the bytes of an Epitrend binary data file into binary_data
+void FileReader::decodeEpitrendBinaryData(
+    const EpitrendBinaryFormat& binary_format,
+    const char* bytes,
+    std::size_t size,
+    const std::string& fullpath,
+    EpitrendBinaryData& binary_data,
+    const std::string& caller,
+    EpitrendWatermarks* watermarks,
+    bool verbose
+) {
+    // The file is a flat array of float time,value pairs; pair 0 is not part of any data item
+    const EpitrendBinaryFormat::ValuePair* pairs = reinterpret_cast<const EpitrendBinaryFormat::ValuePair*>(bytes);
+    const long long pair_count = static_cast<long long>(size / sizeof(EpitrendBinaryFormat::ValuePair));
+
+    // Validate the layout of every data item once, so the decode loop needs no bounds checks
+    for (const auto& name_item : binary_format.getDataItems()) {
+        const EpitrendBinaryFormat::DataItem& item = name_item.second;
+        if (item.TotalValues <= 0) {
+            continue; // Nothing to read for empty data items
+        }
+        if (item.ValueOffset < 0 ||
+            static_cast<long long>(item.ValueOffset) + item.TotalValues + 1 > pair_count) {
+            throw std::runtime_error("Error " + caller + " function call: DataItem " + item.Name +
+                " (ValueOffset " + std::to_string(item.ValueOffset) + ", TotalValues " +
+                std::to_string(item.TotalValues) + ") exceeds the " + std::to_string(pair_count) +
+                " values in file: " + fullpath);
+        }
+    }
+
+    if (verbose) {
+        std::cout << "Decoding " << pair_count << " time,value pairs from: " << fullpath << "\n";
+    }
+
+    // Loop through all the data items, reusing the column buffers between items
+    const double current_day = static_cast<double>(binary_format.getCurrentDay());
+    std::vector<double> times, values;
+    std::size_t skipped_items = 0;
+    for (const auto& name_item : binary_format.getDataItems()) {
+        const std::string& data_item_name = name_item.first;
+        const EpitrendBinaryFormat::DataItem& current_data_item = name_item.second;
+        if (current_data_item.TotalValues <= 0) {
+            continue;
+        }
+
+        // Index the mapped pairs from the offset to the total number of items in the data item
+        const EpitrendBinaryFormat::ValuePair* first = pairs + current_data_item.ValueOffset + 1;
+        const EpitrendBinaryFormat::ValuePair* last = first + current_data_item.TotalValues;
+
+        // Incremental read: only decode the samples after the item's watermark
+        if (watermarks) {
+            EpitrendItemWatermark& watermark = (*watermarks)[data_item_name];
+            const EpitrendBinaryFormat::ValuePair& last_pair = *(last - 1);
+
+            // Same file, same layout, same last sample and already sent: nothing new
+            const bool unchanged = watermark.fullpath == fullpath &&
+                watermark.ValueOffset == current_data_item.ValueOffset &&
+                watermark.TotalValues == current_data_item.TotalValues &&
+                std::memcmp(&watermark.lastPair, &last_pair, sizeof(last_pair)) == 0;
+            watermark.fullpath = fullpath;
+            watermark.ValueOffset = current_data_item.ValueOffset;
+            watermark.TotalValues = current_data_item.TotalValues;
+            watermark.lastPair = last_pair;
+            if (unchanged && current_day + last_pair.Time <= watermark.sentTime) {
+                ++skipped_items;
+                continue;
+            }
+
+            // The time column is ascending, so binary search for the first unsent sample
+            const double sent_time = watermark.sentTime;
+            first = std::upper_bound(first, last, sent_time,
+                [current_day](double time, const EpitrendBinaryFormat::ValuePair& pair) {
+                    return time < current_day + pair.Time;
+                });
+            if (first == last) {
+                ++skipped_items;
+                continue;
+            }
+        }
+
+        const std::size_t count = static_cast<std::size_t>(last - first);
+        times.resize(count);
+        values.resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            times[i] = current_day + first[i].Time;
+            values[i] = first[i].Value;
+        }
+
+        // Hand the whole data item to the columnar store at once
+        binary_data.appendRange(data_item_name, times, values, verbose);
+    }
+
+    if (verbose && watermarks) {
+        std::cout << "Skipped " << skipped_items << " unchanged data items in: " << fullpath << "\n";
+    }
+}
+
 // Parse the Epitrend binary format file
 EpitrendBinaryFormat FileReader::parseEpitrendBinaryFormatFile(
     const Config& config,
@@ -189,38 +309,8 @@ void FileReader::parseEpitrendBinaryDataFile(
         std::cout << "Opening file: " << fullpath << "\n";
     }
 
-    // Open the file
-    std::ifstream file(fullpath);
-    if (!file.is_open()) {
-        throw std::runtime_error("Error parseEpitrendBinaryDataFile function call: Could not open file: " + fullpath);
-    }
-
-    // Load binary data into a buffer
-    std::vector<double> binary_buffer;
-    float value;
-
-    // Read the binary data
-    while (file.read(reinterpret_cast<char*>(&value), sizeof(value))) {
-        binary_buffer.push_back(value);
-    }
-
-    // Loop through all the data item names
-    for(const std::string& data_item_name : binary_format.getAllDataItemNames()) {
-        // For each name, get the time data and
-        // Index the binary file from the offset to the total number of items in each data items            
-        EpitrendBinaryFormat::DataItem current_data_item = binary_format.getDataItem(data_item_name);
-        int start_index = current_data_item.ValueOffset;
-        int end_index = current_data_item.TotalValues + start_index;
-        
-        // Looping through the time,value pairs for current date item name
-        for(int i = (start_index+1) * 2; i < (end_index+1) * 2; i+=2) { 
-            double current_time = static_cast<double>(binary_format.getCurrentDay()) + binary_buffer.at(i);
-            binary_data.addDataItem(data_item_name, {current_time, (double) binary_buffer.at(i+1)}, verbose);
-
-        }
-
-    }
-
+    // Decode the data items straight out of the mapped file
+    decodeEpitrendBinaryDataFile(binary_format, fullpath, binary_data, "parseEpitrendBinaryDataFile", nullptr, verbose);
 }
 
 // Parse the server Epitrend binary format file
@@ -233,25 +323,7 @@ EpitrendBinaryFormat FileReader::parseServerEpitrendBinaryFormatFile(
     int hour,
     bool verbose
 ) {
-    // Array for month names
-    const std::string MONTH_NAMES[] = {
-        "Jan", "Feb", "Mar", "Apr", "May", "Jun", 
-        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
-    };
-
-    // Validate month input
-    if (month < 1 || month > 12) {
-        throw std::invalid_argument("Invalid month: " + std::to_string(month));
-    }
-
-    // Construct the file path dynamically
-    std::ostringstream oss;
-    oss << config.getServerEpitrendDataDir() << GM << " Molly/"
-        << "EpiTrend/EpiTrendData/"
-        << std::setfill('0') << year << "/"
-        << std::setw(2) << month << "-" << MONTH_NAMES[month - 1] << "/"
-        << std::setw(2) << day << "day-" << std::setw(2) << hour << "hr.txt";
-    std::string fullpath = oss.str();
+    std::string fullpath = serverEpitrendBinaryFormatPath(config, GM, year, month, day, hour);
 
     if (verbose) {
         std::cout << "Opening file: " << fullpath << "\n";
@@ -263,6 +335,11 @@ EpitrendBinaryFormat FileReader::parseServerEpitrendBinaryFormatFile(
         throw std::runtime_error("Error parseServerEpitrendBinaryFormatFile function call: Could not open file: " + fullpath);
     }
 
+    return readEpitrendBinaryFormat(file, verbose);
+}
+
+// Internal parse of the lines of an Epitrend binary format file
+EpitrendBinaryFormat FileReader::readEpitrendBinaryFormat(std::istream& file, bool verbose) {
     EpitrendBinaryFormat binaryFormat;
     std::string line;
     int lineNumber = 0;
@@ -359,8 +436,6 @@ EpitrendBinaryFormat FileReader::parseServerEpitrendBinaryFormatFile(
         }
     }
 
-    file.close();
-
     // Final summary
     if (verbose) {
         binaryFormat.printSummary();
@@ -379,6 +454,58 @@ void FileReader::parseServerEpitrendBinaryDataFile(
     int day,
     int hour,
     bool verbose
+) {
+    readServerEpitrendBinaryDataFile(config, binary_data, GM, year, month, day, hour, nullptr, verbose);
+}
+
+// Parse the new tail of the Epitrend binary data file
+void FileReader::parseServerEpitrendBinaryDataFile(
+    const Config& config,
+    EpitrendBinaryData& binary_data,
+    const std::string& GM,
+    int year,
+    int month,
+    int day,
+    int hour,
+    EpitrendWatermarks& watermarks,
+    bool verbose
+) {
+    readServerEpitrendBinaryDataFile(config, binary_data, GM, year, month, day, hour, &watermarks, verbose);
+}
+
+// Path of the server Epitrend binary format file
+std::string FileReader::serverEpitrendBinaryFormatPath(
+    const Config& config,
+    const std::string& GM,
+    int year,
+    int month,
+    int day,
+    int hour
+) {
+    return serverEpitrendHourPath(config, GM, year, month, day, hour, "hr.txt");
+}
+
+// Path of the server Epitrend binary data file
+std::string FileReader::serverEpitrendBinaryDataPath(
+    const Config& config,
+    const std::string& GM,
+    int year,
+    int month,
+    int day,
+    int hour
+) {
+    return serverEpitrendHourPath(config, GM, year, month, day, hour, "hr-binary.txt");
+}
+
+// Internal path of a server Epitrend file of GM for the given hour
+std::string FileReader::serverEpitrendHourPath(
+    const Config& config,
+    const std::string& GM,
+    int year,
+    int month,
+    int day,
+    int hour,
+    const std::string& suffix
 ) {
     // Array for month names
     const std::string MONTH_NAMES[] = {
@@ -386,9 +513,10 @@ void FileReader::parseServerEpitrendBinaryDataFile(
         "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
     };
 
-    // Parse the Epitrend binary format object
-    EpitrendBinaryFormat binary_format = 
-        FileReader::parseServerEpitrendBinaryFormatFile(config, GM, year, month, day, hour, verbose);
+    // Validate month input
+    if (month < 1 || month > 12) {
+        throw std::invalid_argument("Invalid month: " + std::to_string(month));
+    }
 
     // Construct the file path dynamically
     std::ostringstream oss;
@@ -396,45 +524,63 @@ void FileReader::parseServerEpitrendBinaryDataFile(
         << "EpiTrend/EpiTrendData/"
         << std::setfill('0') << year << "/"
         << std::setw(2) << month << "-" << MONTH_NAMES[month - 1] << "/"
-        << std::setw(2) << day << "day-" << std::setw(2) << hour << "hr-binary.txt";
-    std::string fullpath = oss.str();
-
-    if (verbose) {
-        std::cout << "Opening file: " << fullpath << "\n";
-    }
+        << std::setw(2) << day << "day-" << std::setw(2) << hour << suffix;
+    return oss.str();
+}
 
-    // Open the file
-    std::ifstream file(fullpath);
-    if (!file.is_open()) {
-        throw std::runtime_error("Error parseServerEpitrendBinaryDataFile function call: Could not open file: " + fullpath);
-    }
+// Parse an Epitrend hour whose files were read into memory
+void FileReader::parseLoadedEpitrendBinaryDataFile(
+    const std::string& format_bytes,
+    const std::string& data_bytes,
+    const std::string& fullpath,
+    EpitrendBinaryData& binary_data,
+    bool verbose
+) {
+    std::istringstream format_lines(format_bytes);
+    EpitrendBinaryFormat binary_format = readEpitrendBinaryFormat(format_lines, verbose);
 
-    // Load binary data into a buffer
-    std::vector<double> binary_buffer;
-    float value;
+    decodeEpitrendBinaryData(binary_format, data_bytes.data(), data_bytes.size(), fullpath, binary_data,
+        "parseLoadedEpitrendBinaryDataFile", nullptr, verbose);
+}
 
-    // Read the binary data
-    while (file.read(reinterpret_cast<char*>(&value), sizeof(value))) {
-        binary_buffer.push_back(value);
+// Advance the watermarks once the data has been written
+void FileReader::commitEpitrendWatermarks(
+    const EpitrendBinaryData& sent_data,
+    EpitrendWatermarks& watermarks
+) {
+    for (const auto& series : sent_data.getAllSeries()) {
+        if (series.samples.empty()) {
+            continue;
+        }
+        EpitrendItemWatermark& watermark = watermarks[series.name];
+        watermark.sentTime = std::max(watermark.sentTime, series.samples.times.back());
     }
+}
 
-    // Loop through all the data item names
-    for(const std::string& data_item_name : binary_format.getAllDataItemNames()) {
-        // For each name, get the time data and
-        // Index the binary file from the offset to the total number of items in each data items            
-        EpitrendBinaryFormat::DataItem current_data_item = binary_format.getDataItem(data_item_name);
-        int start_index = current_data_item.ValueOffset;
-        int end_index = current_data_item.TotalValues + start_index;
-        
-        // Looping through the time,value pairs for current date item name
-        for(int i = (start_index+1) * 2; i < (end_index+1) * 2; i+=2) { 
-            double current_time = static_cast<double>(binary_format.getCurrentDay()) + binary_buffer.at(i);
-            binary_data.addDataItem(data_item_name, {current_time, (double) binary_buffer.at(i+1)}, verbose);
+// Internal parse of the server Epitrend binary data file
+void FileReader::readServerEpitrendBinaryDataFile(
+    const Config& config,
+    EpitrendBinaryData& binary_data,
+    const std::string& GM,
+    int year,
+    int month,
+    int day,
+    int hour,
+    EpitrendWatermarks* watermarks,
+    bool verbose
+) {
+    // Parse the Epitrend binary format object
+    EpitrendBinaryFormat binary_format = 
+        FileReader::parseServerEpitrendBinaryFormatFile(config, GM, year, month, day, hour, verbose);
 
-        }
+    std::string fullpath = serverEpitrendBinaryDataPath(config, GM, year, month, day, hour);
 
+    if (verbose) {
+        std::cout << "Opening file: " << fullpath << "\n";
     }
 
+    // Decode the data items straight out of the mapped file
+    decodeEpitrendBinaryDataFile(binary_format, fullpath, binary_data, "parseServerEpitrendBinaryDataFile", watermarks, verbose);
 }
 
 // Parse the RGA data file
@@ -445,10 +591,60 @@ void FileReader::parseRGADataFile(
     int month,
     int day,
     bool verbose
+) {
+    std::string fullpath = findRGADataFile("data/MBE1/", GM, year, month, day, "parseRGADataFile", verbose);
+    parseRGADataFileAt(fullpath, rga_data, GM, "parseRGADataFile", verbose);
+}
+
+// Parse the RGA data file
+void FileReader::parseServerRGADataFile(
+    const Config& config,
+    RGAData& rga_data,
+    const std::string& GM,
+    int year,
+    int month,
+    int day,
+    bool verbose
+) {
+    std::string fullpath = findServerRGADataFile(config, GM, year, month, day, verbose);
+    parseRGADataFileAt(fullpath, rga_data, GM, "parseServerRGADataFile", verbose);
+}
+
+// Parse a located server RGA data file
+void FileReader::parseServerRGADataFile(
+    const std::string& fullpath,
+    RGAData& rga_data,
+    const std::string& GM,
+    bool verbose
+) {
+    parseRGADataFileAt(fullpath, rga_data, GM, "parseServerRGADataFile", verbose);
+}
+
+// Find the server RGA daily log
+std::string FileReader::findServerRGADataFile(
+    const Config& config,
+    const std::string& GM,
+    int year,
+    int month,
+    int day,
+    bool verbose
+) {
+    return findRGADataFile(config.getServerRGADataDir(), GM, year, month, day, "parseServerRGADataFile", verbose);
+}
+
+// Find the RGA daily log below root
+std::string FileReader::findRGADataFile(
+    const std::string& root,
+    const std::string& GM,
+    int year,
+    int month,
+    int day,
+    const std::string& caller,
+    bool verbose
 ) {
     // Construct the directory path
     std::ostringstream dir_oss;
-    dir_oss << "data/MBE1/"
+    dir_oss << root
             << std::setfill('0') << std::setw(4) << year << "-"
             << std::setw(3) << month << "-"
             << std::setw(2) << day;
@@ -456,7 +652,7 @@ void FileReader::parseRGADataFile(
 
     // Check if the directory exists
     if (!fs::exists(directory) || !fs::is_directory(directory)) {
-        throw std::runtime_error("Error parseRGADataFile function call:"
+        throw std::runtime_error("Error " + caller + " function call:"
         " Directory does not exist: " 
         + directory);
     }
@@ -470,22 +666,15 @@ void FileReader::parseRGADataFile(
     std::string pattern = oss.str();
 
     if (verbose) {
-        std::cout << "In parseRGADataFile call: constructed directory path: " << directory << "\n";
-        std::cout << "In parseRGADataFile call: constructed regex pattern: " << pattern << "\n";
+        std::cout << "In " << caller << " call: constructed directory path: " << directory << "\n";
+        std::cout << "In " << caller << " call: constructed regex pattern: " << pattern << "\n";
     }
 
     // Compile the regex pattern
     std::regex regex_pattern(pattern);
 
-    // Search for matching files
-    bool file_found = false;
-
-    // Storage structure for all lines in file
-    std::vector<std::string> lines;
-
-
     if (verbose) 
-        std::cout << "In parseRGADataFile call: searching for"
+        std::cout << "In " << caller << " call: searching for"
         " matching files in directory: " << directory << "\n";
     for (const auto& entry : fs::directory_iterator(directory)) {
         if (fs::is_regular_file(entry.path())) {
@@ -493,320 +682,245 @@ void FileReader::parseRGADataFile(
             if (std::regex_match(filename, regex_pattern)) {
                 std::string fullpath = entry.path().string();
                 if (verbose) 
-                    std::cout << "In parseRGADataFile call: found matching file: " << fullpath << "\n";
-
-                // Open the file
-                std::ifstream file(fullpath);
-                if (!file.is_open()) {
-                    throw std::runtime_error("Error parseRGADataFile function call:"
-                    " Could not open file: " + fullpath);
-                }
-
-                // Load all the lines into a buffer
-                std::string line;
-                while (std::getline(file, line)) {
-                    lines.push_back(line);
-                }
-
-                file.close();
-                file_found = true;
-                break; // Stop searching after finding the first matching file
+                    std::cout << "In " << caller << " call: found matching file: " << fullpath << "\n";
+                return fullpath; // Stop searching after finding the first matching file
             }
         }
     }
-    
+
     // Throw an error if no matching file is found
-    if (!file_found) {
-        throw std::runtime_error("Error parseRGADataFile function call:"
-        " No matching file found for pattern: " + pattern);
+    throw std::runtime_error("Error " + caller + " function call:"
+    " No matching file found for pattern: " + pattern);
+}
+
+// Parse a whole RGA daily log in one pass over its mapping
+void FileReader::parseRGADataFileAt(
+    const std::string& fullpath,
+    RGAData& rga_data,
+    const std::string& GM,
+    const std::string& caller,
+    bool verbose
+) {
+    // Map the file (throws if it cannot be opened)
+    MappedFile file;
+    try {
+        file = MappedFile(fullpath);
+    } catch (const std::exception&) {
+        throw std::runtime_error("Error " + caller + " function call: Could not open file: " + fullpath);
     }
 
     // Ensure the data file has a headers row
-    if (lines.empty()) {
-        throw std::runtime_error("Error parseRGADataFile function call: Data file is empty.");
+    if (file.size() == 0) {
+        throw std::runtime_error("Error " + caller + " function call: Data file is empty.");
     }
 
     // Find the header row
-    size_t header_row_index = 0;
-    for (; header_row_index < lines.size(); ++header_row_index) {
-        if (lines[header_row_index].find("Time Relative (sec)") != std::string::npos) {
-            break;
-        }
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    RGAHeaderLayout layout;
+    bool header_found = false;
+    while (begin < end && !header_found) {
+        const char* newline = static_cast<const char*>(std::memchr(begin, '\n', static_cast<std::size_t>(end - begin)));
+        const char* line_end = newline ? newline : end;
+        header_found = parseRGAHeader(begin, line_end, layout);
+        begin = newline ? newline + 1 : end;
     }
-
-    // Throw an error if no header row is found
-    if (header_row_index == lines.size()) {
-        throw std::runtime_error("Error parseRGADataFile function call: No header row found in the data file.");
+    if (!header_found) {
+        throw std::runtime_error("Error " + caller + " function call: No header row found in the data file.");
     }
 
-    // Process the headers row
-    std::istringstream header_stream(lines[header_row_index]);
-    std::vector<std::string> headers;
-    std::string header;
-    std::vector<double> bins;  // May not need
-    while (std::getline(header_stream, header, '\t')) {
-        if (header != "Time Relative (sec)" && header != "Time Absolute (UTC)" && header != "Time Absolute (Date_Time)" && header != "Step") {
-            bins.push_back(std::stod(header));
-        }
-        headers.push_back(header);
-    }
+    // Parse the remaining rows straight into the scan matrix
+    RGAScan scan;
+    scan.amus = layout.amus;
+    parseRGARows(begin, end, layout, scan, true, false, caller);
 
-    // Map the header to each row entry for all entire time series
-    std::unordered_map<double, std::unordered_map<std::string, std::string>> all_time_series_header_map;
-    for (size_t i = header_row_index + 1; i < lines.size(); ++i) {
-        std::vector<std::string> current_row = FileReader::split(lines.at(i), "\t");
+    // Add time-series data into RGAData object
+    addRGAScan(rga_data, GM, scan, verbose);
+}
 
-        // Check that the numbers of headers and the current line match
-        if (current_row.size() != headers.size())
-            throw std::runtime_error("Error parseRGADataFile function call: Number of headers and row entries do not match.");
-        
-        // Map the headers to the current row entries
-        // THIS ASSUMES THAT THE UNIX TIME IS THE SECOND ENTRY IN THE ROW
-        double unix_time;
-        try {
-            unix_time = std::stod(current_row.at(1));
-        } catch (const std::exception& e) {
-            if (verbose) std::cerr << "Error parseRGADataFile function call: error parsing unix time: " << e.what() << "\n";
-            throw std::runtime_error("Error parseRGADataFile function call: Error parsing unix time");
+// Resolve the RGA header row
+bool FileReader::parseRGAHeader(const char* begin, const char* end, RGAHeaderLayout& layout) {
+    std::string_view line(begin, static_cast<std::size_t>(end - begin));
+    if (line.find("Time Relative (sec)") == std::string_view::npos) {
+        return false;
+    }
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+
+    // Numeric labels are AMU columns; everything else is skipped when reading rows
+    layout = RGAHeaderLayout();
+    std::size_t start = 0;
+    while (true) {
+        std::size_t tab = line.find('\t', start);
+        std::string_view label = line.substr(start, tab == std::string_view::npos ? std::string_view::npos : tab - start);
+        double amu;
+        if (label == "Time Absolute (UTC)") {
+            layout.timeColumn = layout.scanColumn.size();
+            layout.scanColumn.push_back(-1);
+        } else if (parseRGANumber(label.data(), label.data() + label.size(), amu)) {
+            layout.scanColumn.push_back(static_cast<int>(layout.amus.size()));
+            layout.amus.push_back(amu);
+        } else {
+            layout.scanColumn.push_back(-1);
         }
-        for (size_t j = 0; j < headers.size(); ++j) {
-            all_time_series_header_map[unix_time][headers.at(j)] = current_row.at(j);
+        if (tab == std::string_view::npos) {
+            break;
         }
+        start = tab + 1;
     }
+    layout.columnCount = layout.scanColumn.size();
+    return true;
+}
 
-    // Extract the AMUBins struct from input RGAData object
-    std::vector<RGAData::AMUBins> rga_object_bins = rga_data.getBins();
+// Parse the RGA data rows into the scan matrix
+std::size_t FileReader::parseRGARows(
+    const char* begin,
+    const char* end,
+    const RGAHeaderLayout& layout,
+    RGAScan& scan,
+    bool final,
+    bool skip_malformed,
+    const std::string& caller
+) {
+    const std::size_t columns = layout.amus.size();
+    const char* next = begin;
+    while (next < end) {
+        const char* newline = static_cast<const char*>(std::memchr(next, '\n', static_cast<std::size_t>(end - next)));
+        if (!newline && !final) {
+            break; // A partially written row waits for more bytes
+        }
+        const char* line = next;
+        const char* line_end = newline ? newline : end;
+        next = newline ? newline + 1 : end;
+        if (line_end > line && line_end[-1] == '\r') {
+            --line_end;
+        }
 
-    // Add time-series data into RGAData object
-    for (auto& AMUbin_object : rga_object_bins) {
-        std::cout << "Current bin: "; AMUbin_object.print();
-        for (const auto& time_header_map : all_time_series_header_map) {
-            // Extract the time and value from the time_series and header map
-            double current_input_unix_time = time_header_map.first;
-
-            // Calculate the average of the bin values
-            double current_input_value = 0.0;
-            for (const auto& bin : AMUbin_object.bins) {
-                // Extract the value from the time_series and header map
-                std::ostringstream bin_stream;
-                bin_stream.precision(2);
-                bin_stream << std::fixed << bin;
-                std::string bin_search = std::move(bin_stream).str();
-                if (time_header_map.second.find(bin_search) == time_header_map.second.end())
-                    throw std::runtime_error("Error parseRGADataFile function call: bin value not found in header map.");
-
-                // Add the value to the current input value
-                current_input_value += stod(time_header_map.second.at(bin_search));
+        // Walk the cells once, writing the AMU columns straight into a new matrix row
+        const std::size_t row_start = scan.values.size();
+        scan.values.resize(row_start + columns);
+        double unix_time = 0.0;
+        bool time_found = false;
+        const char* error = nullptr;
+        std::size_t column = 0;
+        const char* cell = line;
+        while (true) {
+            const char* tab = static_cast<const char*>(std::memchr(cell, '\t', static_cast<std::size_t>(line_end - cell)));
+            const char* cell_end = tab ? tab : line_end;
+            if (column < layout.columnCount && !error) {
+                double value;
+                if (column == layout.timeColumn) {
+                    time_found = parseRGANumber(cell, cell_end, unix_time);
+                    if (!time_found) error = "Error parsing unix time";
+                } else if (layout.scanColumn[column] >= 0) {
+                    if (parseRGANumber(cell, cell_end, value)) {
+                        scan.values[row_start + static_cast<std::size_t>(layout.scanColumn[column])] = static_cast<float>(value);
+                    } else {
+                        error = "Error parsing value";
+                    }
+                }
             }
-            current_input_value /= AMUbin_object.bins.size();
-            
-            // Add the time-series data to the RGAData object
-            if (verbose) {
-                std::cout << "Adding data to RGAData object: "
-                << std::setprecision(9) << current_input_unix_time 
-                << ", " << current_input_value 
-                << "\n";
+            ++column;
+            if (!tab) {
+                break;
             }
+            cell = tab + 1;
+        }
 
-            // Set the GM for AMUbin_object
-            AMUbin_object.GM = GM;
+        // Check that the numbers of headers and the current line match
+        if (column != layout.columnCount) {
+            error = "Number of headers and row entries do not match";
+        } else if (!error && !time_found) {
+            error = "Error parsing unix time";
+        }
 
-            // Add the data to the RGAData object
-            rga_data.addData(AMUbin_object, current_input_unix_time, current_input_value);
+        if (error) {
+            scan.values.resize(row_start);
+            if (!skip_malformed) {
+                throw std::runtime_error("Error " + caller + " function call: " + error + ".");
+            }
+            // Skip the malformed row rather than stalling every later read on it
+            std::cerr << "Warning in " << caller << " call: " << error << "... skipping row.\n";
+            continue;
         }
+        scan.times.push_back(unix_time);
     }
+    return static_cast<std::size_t>(next - begin);
 }
 
-// Parse the RGA data file
-void FileReader::parseServerRGADataFile(
-    const Config& config,
+// Parse one numeric cell, allowing surrounding spaces and a leading plus sign
+bool FileReader::parseRGANumber(const char* begin, const char* end, double& value) {
+    while (begin < end && *begin == ' ') ++begin;
+    while (end > begin && end[-1] == ' ') --end;
+    if (begin < end && *begin == '+') ++begin;
+    std::from_chars_result result = std::from_chars(begin, end, value);
+    return result.ec == std::errc() && result.ptr == end && begin < end;
+}
+
+// Add the RGA scan into the RGAData object
+void FileReader::addRGAScan(
     RGAData& rga_data,
     const std::string& GM,
-    int year,
-    int month,
-    int day,
+    const RGAScan& scan,
     bool verbose
 ) {
-    // Construct the directory path
-    std::ostringstream dir_oss;
-    dir_oss << config.getServerRGADataDir()
-            << std::setfill('0') << std::setw(4) << year << "-"
-            << std::setw(3) << month << "-"
-            << std::setw(2) << day;
-    std::string directory = dir_oss.str();
-
-    // Check if the directory exists
-    if (!fs::exists(directory) || !fs::is_directory(directory)) {
-        throw std::runtime_error("Error parseServerRGADataFile function call:"
-        " Directory does not exist: " 
-        + directory);
-    }
-
-    // Construct the regex pattern dynamically
-    std::ostringstream oss;
-    oss << "daily log, " << GM << ", RGA MPH .*?, "
-        << std::setfill('0') << std::setw(4) << year << "-"
-        << std::setw(3) << month << "-"
-        << std::setw(2) << day << " .*?\\.dat";
-    std::string pattern = oss.str();
-
-    if (verbose) {
-        std::cout << "In parseServerRGADataFile call: constructed directory path: " << directory << "\n";
-        std::cout << "In parseServerRGADataFile call: constructed regex pattern: " << pattern << "\n";
-    }
-
-    // Compile the regex pattern
-    std::regex regex_pattern(pattern);
-
-    // Search for matching files
-    bool file_found = false;
-
-    // Storage structure for all lines in file
-    std::vector<std::string> lines;
-
-
-    if (verbose) 
-        std::cout << "In parseServerRGADataFile call: searching for"
-        " matching files in directory: " << directory << "\n";
-    for (const auto& entry : fs::directory_iterator(directory)) {
-        if (fs::is_regular_file(entry.path())) {
-            std::string filename = entry.path().filename().string();
-            if (std::regex_match(filename, regex_pattern)) {
-                std::string fullpath = entry.path().string();
-                if (verbose) 
-                    std::cout << "In parseServerRGADataFile call: found matching file: " << fullpath << "\n";
-
-                // Open the file
-                std::ifstream file(fullpath);
-                if (!file.is_open()) {
-                    throw std::runtime_error("Error parseServerRGADataFile function call:"
-                    " Could not open file: " + fullpath);
-                }
-
-                // Load all the lines into a buffer
-                std::string line;
-                while (std::getline(file, line)) {
-                    lines.push_back(line);
-                }
-
-                file.close();
-                file_found = true;
-                break; // Stop searching after finding the first matching file
-            }
-        }
-    }
-    
-    // Throw an error if no matching file is found
-    if (!file_found) {
-        throw std::runtime_error("Error parseServerRGADataFile function call:"
-        " No matching file found for pattern: " + pattern);
-    }
-
-    // Ensure the data file has a headers row
-    if (lines.empty()) {
-        throw std::runtime_error("Error parseServerRGADataFile function call: Data file is empty.");
-    }
-
-    // Find the header row
-    size_t header_row_index = 0;
-    for (; header_row_index < lines.size(); ++header_row_index) {
-        if (lines[header_row_index].find("Time Relative (sec)") != std::string::npos) {
-            break;
-        }
-    }
-
-    // Throw an error if no header row is found
-    if (header_row_index == lines.size()) {
-        throw std::runtime_error("Error parseServerRGADataFile function call: No header row found in the data file.");
-    }
-
-    // Process the headers row
-    std::istringstream header_stream(lines[header_row_index]);
-    std::vector<std::string> headers;
-    std::string header;
-    std::vector<double> bins;  // May not need
-    while (std::getline(header_stream, header, '\t')) {
-        if (header != "Time Relative (sec)" && header != "Time Absolute (UTC)" && header != "Time Absolute (Date_Time)" && header != "Step") {
-            bins.push_back(std::stod(header));
-        }
-        headers.push_back(header);
-    }
-
-    // Map the header to each row entry for all entire time series
-    std::unordered_map<double, std::unordered_map<std::string, std::string>> all_time_series_header_map;
-    for (size_t i = header_row_index + 1; i < lines.size(); ++i) {
-        std::vector<std::string> current_row = FileReader::split(lines.at(i), "\t");
+    addRGAScan(std::vector<RGAData*>{&rga_data}, GM, scan, verbose);
+}
 
-        // Check that the numbers of headers and the current line match
-        if (current_row.size() != headers.size())
-            throw std::runtime_error("Error parseServerRGADataFile function call: Number of headers and row entries do not match.");
-        
-        // Map the headers to the current row entries
-        // THIS ASSUMES THAT THE UNIX TIME IS THE SECOND ENTRY IN THE ROW
-        double unix_time;
-        try {
-            unix_time = std::stod(current_row.at(1));
-        } catch (const std::exception& e) {
-            if (verbose) std::cerr << "Error parseServerRGADataFile function call: error parsing unix time: " << e.what() << "\n";
-            throw std::runtime_error("Error parseServerRGADataFile function call: Error parsing unix time");
-        }
-        for (size_t j = 0; j < headers.size(); ++j) {
-            all_time_series_header_map[unix_time][headers.at(j)] = current_row.at(j);
-        }
+// Add the RGA scan into every RGAData object, integrating all their bins in one pass
+void FileReader::addRGAScan(
+    const std::vector<RGAData*>& rga_data,
+    const std::string& GM,
+    const RGAScan& scan,
+    bool verbose
+) {
+    // Collect the bin layouts of every input RGAData object
+    std::vector<RGAData::BinId> bin_ids;
+    std::vector<std::size_t> first_bin;
+    for (RGAData* data : rga_data) {
+        first_bin.push_back(bin_ids.size());
+        const std::vector<RGAData::BinId>& ids = data->getBinIds();
+        bin_ids.insert(bin_ids.end(), ids.begin(), ids.end());
     }
+    first_bin.push_back(bin_ids.size());
 
-    // Extract the AMUBins struct from input RGAData object
-    std::vector<RGAData::AMUBins> rga_object_bins = rga_data.getBins();
+    // Average every bin over every row at once
+    RGABinKernel kernel(scan.amus, bin_ids, verbose);
+    std::vector<double> averages;
+    kernel.integrate(scan, averages);
 
     // Add time-series data into RGAData object
-    for (auto& AMUbin_object : rga_object_bins) {
-        if (verbose) {std::cout << "Current bin: "; AMUbin_object.print();}
-        for (const auto& time_header_map : all_time_series_header_map) {
-            // Extract the time and value from the time_series and header map
-            double current_input_unix_time = time_header_map.first;
-
-            // Calculate the average of the bin values
-            double current_input_value = 0.0;
-            int bin_counter = 0;
-            for (const auto& bin : AMUbin_object.bins) {
-                // Extract the value from the time_series and header map
-                std::ostringstream bin_stream;
-                bin_stream.precision(2);
-                bin_stream << std::fixed << bin;
-                std::string bin_search = std::move(bin_stream).str();
-                if (time_header_map.second.find(bin_search) == time_header_map.second.end()) {
-                    if (verbose) std::cerr << "Warning parseServerRGADataFile function call: bin value " + bin_search + " not found in header map... excluding this value from the average.";
-                    continue;
-                }
-                // Add the value to the current input value
-                current_input_value += stod(time_header_map.second.at(bin_search));
+    RGAData::BinRegistry& registry = RGAData::BinRegistry::instance();
+    const std::size_t bin_count = kernel.binCount();
+    std::vector<double> values(scan.rows());
+    for (std::size_t d = 0; d < rga_data.size(); ++d) {
+        for (std::size_t b = first_bin[d]; b < first_bin[d + 1]; ++b) {
+            if (verbose) {std::cout << "Current bin: "; registry.bins(bin_ids[b]).print();}
 
-                // Increment bin counter
-                bin_counter++;
-            }
-            
             // Check if any bins were successfully found
-            if (bin_counter == 0) {
+            if (!kernel.hasColumns(b)) {
                 // Do not add current value into the database
                 continue;
             }
 
-            // Calculate the average
-            current_input_value /= static_cast<double>(bin_counter);
-            
-            // Add the time-series data to the RGAData object
-            if (verbose) {
-                std::cout << "Adding data to RGAData object: "
-                << std::setprecision(9) << current_input_unix_time 
-                << ", " << current_input_value 
-                << "\n";
-            }
+            // The same bins under the GM of the log
+            const RGAData::BinId id = registry.intern(bin_ids[b], GM);
 
-            // Set the GM for AMUbin_object
-            AMUbin_object.GM = GM;
+            for (std::size_t i = 0; i < scan.rows(); ++i) {
+                values[i] = averages[i * bin_count + b];
+
+                // Add the time-series data to the RGAData object
+                if (verbose) {
+                    std::cout << "Adding data to RGAData object: "
+                    << std::setprecision(9) << scan.times[i]
+                    << ", " << values[i] 
+                    << "\n";
+                }
+            }
 
             // Add the data to the RGAData object
-            rga_data.addData(AMUbin_object, current_input_unix_time, current_input_value);
+            rga_data[d]->appendRange(id, scan.times.data(), values.data(), scan.rows());
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,113 @@
+#include "GzipCompressor.hpp"
+
+GzipCompressor::GzipCompressor(int level) : level_(level) {
+    stream = z_stream();
+    // windowBits 15 + 16 writes a gzip header and trailer instead of a zlib one
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("Error in GzipCompressor constructor: Failed to initialize zlib with level " + std::to_string(level));
+    }
+}
+
+GzipCompressor::~GzipCompressor() {
+    deflateEnd(&stream);
+}
+
+const std::string& GzipCompressor::compress(const char* data, std::size_t length) {
+    reset(length);
+    deflateInput(data, length, Z_FINISH);
+    recordRatio(length);
+    return out;
+}
+
+const std::string& GzipCompressor::compress(RequestBody& source) {
+    const std::size_t length = source.size() == RequestBody::UNKNOWN_SIZE ? 0 : static_cast<std::size_t>(source.size());
+    reset(length);
+
+    char chunk[64 * 1024];
+    source.rewind();
+    std::size_t total = 0;
+    std::size_t count;
+    while ((count = source.read(chunk, sizeof(chunk))) > 0) {
+        deflateInput(chunk, count, Z_NO_FLUSH);
+        total += count;
+    }
+    deflateInput(nullptr, 0, Z_FINISH);
+    recordRatio(total);
+    return out;
+}
+
+std::string GzipCompressor::decompress(const std::string& gzipped) {
+    z_stream inflater = z_stream();
+    if (inflateInit2(&inflater, 15 + 16) != Z_OK) {
+        throw std::runtime_error("Error in GzipCompressor::decompress call: Failed to initialize zlib");
+    }
+    inflater.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(gzipped.data()));
+    inflater.avail_in = static_cast<uInt>(gzipped.size());
+
+    // Line protocol usually shrinks four to ten times
+    std::string plain(4 * gzipped.size() + 1024, '\0');
+    for (;;) {
+        const std::size_t used = inflater.total_out;
+        if (used == plain.size()) {
+            plain.resize(plain.size() * 2);
+        }
+        inflater.next_out = reinterpret_cast<Bytef*>(&plain[used]);
+        inflater.avail_out = static_cast<uInt>(plain.size() - used);
+        const int result = inflate(&inflater, Z_NO_FLUSH);
+        if (result == Z_STREAM_END) {
+            break;
+        }
+        if ((result != Z_OK && result != Z_BUF_ERROR) || (inflater.avail_in == 0 && inflater.avail_out > 0)) {
+            inflateEnd(&inflater);
+            throw std::runtime_error("Error in GzipCompressor::decompress call: Corrupt or truncated body of " +
+                std::to_string(gzipped.size()) + " bytes");
+        }
+    }
+    plain.resize(inflater.total_out);
+    inflateEnd(&inflater);
+    return plain;
+}
+
+void GzipCompressor::reset(std::size_t length) {
+    if (deflateReset(&stream) != Z_OK) {
+        throw std::runtime_error("Error in GzipCompressor::compress call: Failed to reset zlib stream");
+    }
+    // Room for the worst case of the expected length, so one pass is usually enough
+    out.resize(deflateBound(&stream, static_cast<uLong>(length)));
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+}
+
+void GzipCompressor::deflateInput(const char* data, std::size_t length, int flush) {
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(length);
+    for (;;) {
+        if (stream.avail_out == 0) {
+            // Grow the output and continue where deflate stopped
+            std::size_t used = out.size();
+            out.resize(used * 2 + 1024);
+            stream.next_out = reinterpret_cast<Bytef*>(&out[used]);
+            stream.avail_out = static_cast<uInt>(out.size() - used);
+        }
+        int result = deflate(&stream, flush);
+        if (result == Z_STREAM_END) {
+            out.resize(stream.total_out);
+            return;
+        }
+        if (result != Z_OK && result != Z_BUF_ERROR) {
+            throw std::runtime_error("Error in GzipCompressor::compress call: Failed to compress " + std::to_string(length) + " bytes");
+        }
+        if (flush == Z_NO_FLUSH && stream.avail_in == 0 && stream.avail_out > 0) {
+            return;
+        }
+    }
+}
+
+void GzipCompressor::recordRatio(std::size_t length) {
+    // Smooth the ratio over recent bodies
+    if (length > 0) {
+        const double observed = static_cast<double>(out.size()) / static_cast<double>(length);
+        ratio_ = sampled ? 0.75 * ratio_ + 0.25 * observed : observed;
+        sampled = true;
+    }
+}
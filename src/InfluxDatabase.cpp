@@ -1,13 +1,6 @@
 #include "InfluxDatabase.hpp"
-
-void CurlHeaders::append(const std::string& header) {
-    headers_ = curl_slist_append(headers_, header.c_str());
-    if (!headers_) {
-        throw std::runtime_error("Failed to append header.");
-    }
-}
-
-//=============================END OF CURLHEADERS CLASS METHODS==============================
+#include "SensorRegistry.hpp"
+#include "LineProtocolEncoder.hpp"
 
 InfluxDatabase::InfluxDatabase() : isConnected(false), serverInfo("localhost", 8086, ""){}
 
@@ -22,6 +15,13 @@ InfluxDatabase::InfluxDatabase(const std::string& host, int port,
 
 
 InfluxDatabase::~InfluxDatabase() {
+    // Nothing may reach batcher_ once this object is gone
+    if (spool_) {
+        spool_->stopDrain();
+    }
+    if (destination_) {
+        SharedSink::instance().unwatch(destination_, &batcher_);
+    }
     disconnect();
 }
 
@@ -31,17 +31,6 @@ bool InfluxDatabase::connect(const std::string& host, int port,
                             const std::string& precision, const std::string& token,
                             bool verbose) {
     serverInfo = influxdb_cpp::server_info(host, port, bucket, user, password, precision, token);
-    
-    // Test connection by sending a simple query or ping
-    std::string response;
-    int result = influxdb_cpp::query(response, "SHOW DATABASES", serverInfo);
-    if (result != 0) {
-        if (verbose) {
-            std::cerr << "Failed to connect to InfluxDB: " << response << "\n";
-        }
-        throw std::runtime_error("Failed to connect to InfluxDB: " + response);
-    }
-
     host_ = host;
     port_ = port;
     org_ = org;
@@ -50,6 +39,32 @@ bool InfluxDatabase::connect(const std::string& host, int port,
     password_ = password;
     precision_ = precision;
     token_ = token;
+
+    std::string base = "http://" + host_ + ":" + std::to_string(port_);
+    writeUrl_ = base + "/api/v2/write?org=" + org_ + "&bucket=" + bucket_ + "&precision=" + precision_;
+    queryUrl_ = base + "/api/v2/query?org=" + org_;
+
+    // Every request of this object reports to the breaker of its server
+    breaker_ = &CircuitBreaker::forSink(host_ + ":" + std::to_string(port_));
+    session.setBreaker(breaker_);
+    resetDestination(); // The destination was made for the old url and breaker
+
+    // Test connection by sending a simple query; this also opens the keep-alive connection
+    std::string response;
+    long result;
+    try {
+        result = requestV1("query", "&q=SHOW+DATABASES", nullptr, response);
+    } catch (const std::exception& e) {
+        response = e.what();
+        result = -1;
+    }
+    if (result != 0) {
+        if (verbose) {
+            std::cerr << "Failed to connect to InfluxDB: " << response << "\n";
+        }
+        throw std::runtime_error("Failed to connect to InfluxDB: " + response);
+    }
+
     isConnected = true;
     if (verbose) {
         std::cout << "Connected to InfluxDB at " << host << ":" << port << "\n";
@@ -75,7 +90,13 @@ bool InfluxDatabase::checkConnection(bool verbose) {
         return false;
     }
     std::string response;
-    int result = influxdb_cpp::query(response, "SHOW DATABASES", serverInfo);
+    long result;
+    try {
+        result = requestV1("query", "&q=SHOW+DATABASES", nullptr, response);
+    } catch (const std::exception& e) {
+        response = e.what();
+        result = -1;
+    }
     if (result != 0) {
         if (verbose) {
             std::cerr << "Connection test failed: " << response << "\n";
@@ -89,6 +110,27 @@ bool InfluxDatabase::checkConnection(bool verbose) {
     return true;
 }
 
+// Internal v1 API request through the keep-alive session, with the same URL layout as influxdb_cpp
+long InfluxDatabase::requestV1(const char* uri, const std::string& querystring,
+    RequestBody* body, std::string& response) {
+    std::string url = "http://" + host_ + ":" + std::to_string(port_) + "/" + uri + "?db=" + bucket_;
+    if (token_.empty()) {
+        url += "&u=" + user_ + "&p=" + password_;
+    }
+    url += (std::strcmp(uri, "write") ? "&epoch=" : "&precision=") + precision_ + querystring;
+
+    CurlHeaders headers;
+    if (!token_.empty()) {
+        headers.append("Authorization: Token " + token_);
+    }
+
+    response.clear();
+    long status = body ?
+        session.post(url, headers, *body, response) :
+        session.get(url, headers, response);
+    return status / 100 == 2 ? 0 : status;
+}
+
 bool InfluxDatabase::writeData(const std::string& measurement, const std::string& tags,
                                const std::string& fields, long long timestamp, bool verbose) {
     if (!isConnected) {
@@ -110,8 +152,10 @@ bool InfluxDatabase::writeData(const std::string& measurement, const std::string
     }
 
     // Send data
+    const std::string line = lineProtocol.str();
+    BufferBody body(line);
     std::string response;
-    int result = influxdb_cpp::detail::inner::http_request("POST", "write", "", lineProtocol.str(), serverInfo, &response);
+    long result = requestV1("write", "", &body, response);
     if (result != 0) {
         if (verbose) {
             std::cerr << "Error writing data to InfluxDB: " << response << "\n";
@@ -120,7 +164,7 @@ bool InfluxDatabase::writeData(const std::string& measurement, const std::string
     }
 
     if (verbose) {
-        std::cout << "Data written successfully: " << lineProtocol.str() << "\n"
+        std::cout << "Data written successfully: " << line << "\n"
         << "Reponse: " << response << "\n";
     }
     return true;
@@ -131,13 +175,10 @@ bool InfluxDatabase::writeBatchData(const std::vector<std::string>& dataPoints,
         throw std::runtime_error("Cannot write data: Not connected to InfluxDB.");
     }
 
-    std::ostringstream batchStream;
-    for (const auto& point : dataPoints) {
-        batchStream << point << "\n";
-    }
-
+    // Stream the points straight from the vector
+    LinesBody body(dataPoints);
     std::string response;
-    int result = influxdb_cpp::detail::inner::http_request("POST", "write", "", batchStream.str(), serverInfo, &response);
+    long result = requestV1("write", "", &body, response);
     if (result != 0) {
         if (verbose) {
             std::cerr << "Error writing batch data: " << response << "\n";
@@ -156,77 +197,79 @@ bool InfluxDatabase::writeBatchData2(const std::vector<std::string>& dataPoints,
         throw std::runtime_error("Cannot write data: Not connected to InfluxDB.");
     }
 
-    // Construct the line protocol string
-    std::ostringstream batchStream;
-    for (const auto& point : dataPoints) {
-        batchStream << point << "\n";
+    // Stream (or compress) the points straight from the vector
+    LinesBody body(dataPoints);
+    if (gzip_) {
+        BufferBody compressed(gzip_->compress(body));
+        sendWriteBody(compressed, true, verbose);
+    } else {
+        sendWriteBody(body, false, verbose);
     }
+    return true;
+}
 
-    std::string lineProtocol = batchStream.str();
-
-    // Send the line protocol string to InfluxDB
-    CURL *curl;
-    CURLcode res;
-    curl = curl_easy_init();
-    if(curl) {
-        std::string url = "http://" + host_ + ":" + std::to_string(port_) + "/api/v2/write?org=" + org_ + "&bucket=" + bucket_ + "&precision=" + precision_;
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, lineProtocol.c_str());
+bool InfluxDatabase::writeBatchData2(const std::string& lineProtocol, bool verbose) {
+    if (!isConnected) {
+        throw std::runtime_error("Cannot write data: Not connected to InfluxDB.");
+    }
 
-        // Set the authorization header with the token
-        struct curl_slist *headers = NULL;
-        std::string authHeader = "Authorization: Token " + token_;
-        headers = curl_slist_append(headers, authHeader.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    if (gzip_) {
+        BufferBody compressed(gzip_->compress(lineProtocol));
+        sendWriteBody(compressed, true, verbose);
+    } else {
+        BufferBody body(lineProtocol);
+        sendWriteBody(body, false, verbose);
+    }
 
-        // Capture the response
-        std::string response;
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    // Write response if batch write is successful
+    if (verbose) {
+        std::cout << "Line protocol: \n" << lineProtocol;
+    }
 
-        res = curl_easy_perform(curl);
-        if(res != CURLE_OK) {
-            if (verbose) {
-                std::cerr << "Error in InfluxDatabase::writeBatchData2response: error writing batch data to InfluxDB\n";
-            }
-            curl_easy_cleanup(curl);
-            curl_slist_free_all(headers);
-            throw std::runtime_error("Failed to write batch data to InfluxDB: " + std::string(curl_easy_strerror(res)));
-        }
+    return true;
+}
 
-        // Check for errors in the response
-        if (response.find("\"code\":\"invalid\"") != std::string::npos) {
-            if (verbose) {
-                std::cerr << "Error in InfluxDatabase::writeBatchData2response: detected error from InfluxDB\n";
-            }
-            curl_easy_cleanup(curl);
-            curl_slist_free_all(headers);
-            throw std::runtime_error("Failed to write batch data to InfluxDB: " + response);
-        }
+void InfluxDatabase::sendWriteBody(RequestBody& body, bool gzipped, bool verbose) {
+    // Set the authorization header with the token
+    CurlHeaders headers;
+    headers.append("Authorization: Token " + token_);
+    if (gzipped) {
+        headers.append("Content-Encoding: gzip");
+    }
 
-        // Write response if batch write is successful
+    // Send the line protocol to InfluxDB over the keep-alive session
+    std::string response;
+    long status;
+    try {
+        status = session.post(writeUrl_, headers, body, response);
+    } catch (const std::exception& e) {
         if (verbose) {
-            std::cout << "Batch data written successfully to org: " << org_ << ", bucket: " << bucket_ << "\n";
-            std::cout << "Line protocol: \n" << lineProtocol;
-            std::cout << "Response:  " + response << "\n" ;
+            std::cerr << "Error in InfluxDatabase::writeBatchData2response: error writing batch data to InfluxDB\n";
         }
+        throw std::runtime_error("Failed to write batch data to InfluxDB: " + std::string(e.what()));
+    }
 
-            curl_easy_cleanup(curl);
-            curl_slist_free_all(headers);
+    // Check for errors in the response
+    if (status / 100 != 2 || response.find("\"code\":\"invalid\"") != std::string::npos) {
+        if (verbose) {
+            std::cerr << "Error in InfluxDatabase::writeBatchData2response: detected error from InfluxDB\n";
         }
+        throw std::runtime_error("Failed to write batch data to InfluxDB (HTTP " + std::to_string(status) + "): " + response);
+    }
 
-    return true;
+    if (verbose) {
+        std::cout << "Batch data written successfully to org: " << org_ << ", bucket: " << bucket_
+        << " (" << body.size() << (gzipped ? " gzipped" : "") << " bytes)\n";
+        std::cout << "Response:  " + response << "\n" ;
+    }
 }
 
-size_t InfluxDatabase::WriteCallback(void* contents, size_t size, size_t nmemb, std::string* s) {
-    size_t newLength = size * nmemb;
-    try {
-        s->append((char*)contents, newLength);
-    } catch (std::bad_alloc& e) {
-        // Handle memory problem
-        return 0;
+void InfluxDatabase::setGzipCompression(int level) {
+    if (level < 0 || level > 9) {
+        throw std::invalid_argument("Error in InfluxDatabase::setGzipCompression call: gzip level must be 0-9, got " + std::to_string(level));
     }
-    return newLength;
+    gzip_ = level > 0 ? std::make_unique<GzipCompressor>(level) : nullptr;
+    resetDestination();
 }
 
 std::string InfluxDatabase::queryData(const std::string& query, bool verbose) {
@@ -237,8 +280,10 @@ std::string InfluxDatabase::queryData(const std::string& query, bool verbose) {
         throw std::invalid_argument("Query string is empty.");
     }
 
+    std::string querystring("&q=");
+    influxdb_cpp::url_encode(querystring, query);
     std::string response;
-    int result = influxdb_cpp::query(response, query, serverInfo);
+    long result = requestV1("query", querystring, nullptr, response);
     if (result != 0) {
         if (verbose) {
             std::cerr << "Error querying InfluxDB: " << response << "\n";
@@ -254,27 +299,13 @@ std::string InfluxDatabase::queryData(const std::string& query, bool verbose) {
 }
 
 bool InfluxDatabase::queryData2(std::string& response, const std::string& query) {
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        throw std::runtime_error("Failed to initialize cURL.");
-    }
-
-    std::string url = "http://" + host_ + ":" + std::to_string(port_) + "/api/v2/query?org=" + org_;
     CurlHeaders headers;
     headers.append("Content-Type: application/vnd.flux");
     headers.append("Authorization: Token " + token_);
 
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers.get());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, query.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_easy_cleanup(curl);
-
-    if (res != CURLE_OK) {
-        throw std::runtime_error("cURL query failed: " + std::string(curl_easy_strerror(res)));
+    long status = session.post(queryUrl_, headers, query.data(), query.size(), response);
+    if (status / 100 != 2) {
+        throw std::runtime_error("cURL query failed (HTTP " + std::to_string(status) + "): " + response);
     }
 
     return true;
@@ -451,7 +482,181 @@ long long InfluxDatabase::convertSecondsFromUnixToPrecisionFromUnix(double unix_
     }
 }
 
-bool InfluxDatabase::copyEpitrendToBucket(EpitrendBinaryData data, bool verbose){
+void InfluxDatabase::setMaxInFlightWrites(int max_in_flight) {
+    if (max_in_flight < 1) {
+        throw std::invalid_argument("Error in InfluxDatabase::setMaxInFlightWrites call: need at least one write in flight, got " + std::to_string(max_in_flight));
+    }
+    maxInFlightWrites_ = max_in_flight;
+    resetDestination();
+}
+
+void InfluxDatabase::enableSpool(const std::string& directory) {
+    if (spool_) {
+        spool_->stopDrain();
+    }
+    spool_ = std::make_unique<WriteSpool>(directory);
+    startSpoolDrain();
+}
+
+// Internal switch to a new destination; the writes already handed over are not affected
+void InfluxDatabase::resetDestination() {
+    if (spool_) {
+        spool_->stopDrain();
+    }
+    if (destination_) {
+        SharedSink::instance().unwatch(destination_, &batcher_);
+        destination_.reset();
+    }
+    if (spool_) {
+        startSpoolDrain();
+    }
+}
+
+// Internal start of the spool drain, which hands the spooled batches to the shared sink
+void InfluxDatabase::startSpoolDrain() {
+    // The writer of the sink keeps a backfill drain within its share of the requests in flight
+    spool_->startDrain([this](std::string lines, std::vector<int> sensor_ids) {
+        return SharedSink::instance().push(sinkDestination(), std::move(lines), std::move(sensor_ids), SPOOL_RETRY_CALLS, writePriority_, sinkOrigin_);
+    }, 2 * static_cast<std::size_t>(maxInFlightWrites_));
+}
+
+// Internal lookup of the shared sink destination of this bucket, on first use
+const std::shared_ptr<SharedSink::Destination>& InfluxDatabase::sinkDestination() {
+    std::lock_guard<std::mutex> lock(destinationMutex_);
+    if (!destination_) {
+        destination_ = SharedSink::instance().destination(writeUrl_, token_, bucket_, maxInFlightWrites_,
+            gzip_ ? gzip_->level() : 0, breaker_);
+        SharedSink::instance().watch(destination_, &batcher_);
+    }
+    return destination_;
+}
+
+// Internal hand-over of an encoded batch to the spool or the shared sink
+std::future<void> InfluxDatabase::submitBatch(std::string lines, std::vector<int> sensor_ids, int retry_calls) {
+    if (!isConnected) {
+        throw std::runtime_error("Cannot write data: Not connected to InfluxDB.");
+    }
+
+    // A spooled batch is safe on disk, so the copy call may go on right away
+    if (spool_) {
+        spool_->append(lines, sensor_ids);
+        std::promise<void> spooled;
+        spooled.set_value();
+        return spooled.get_future();
+    }
+
+    return SharedSink::instance().push(sinkDestination(), std::move(lines), std::move(sensor_ids), retry_calls, writePriority_, sinkOrigin_);
+}
+
+// Internal wait for every submitted batch, so no write outlives the data it was encoded from
+void InfluxDatabase::waitForWrites(std::vector<std::future<void>>& writes, std::vector<std::size_t>& failed,
+                                   const std::string& caller, bool verbose) {
+    std::string error;
+    failed.clear();
+    for (std::size_t i = 0; i < writes.size(); ++i) {
+        try {
+            writes[i].get();
+        } catch (const std::exception& e) {
+            if (failed.empty()) {
+                error = e.what();
+            }
+            failed.push_back(i);
+        }
+    }
+    writes.clear();
+
+    if (!failed.empty()) {
+        if(verbose) std::cerr << "Error in " << caller << " call: " << failed.size() << " batches failed to write to ts table\n";
+        if(verbose) std::cerr << "Error message: " << error << "\n";
+        throw std::runtime_error("Error in " + caller + " call: failed to write to ts table: " + error + "\n");
+    }
+}
+
+void InfluxDatabase::resyncSensorIds(bool verbose) {
+    SensorRegistry::instance().invalidate(bucket_);
+    refreshSensorIds("InfluxDatabase::resyncSensorIds", verbose);
+}
+
+// Internal read of the whole ns measurement into the shared sensor registry
+void InfluxDatabase::refreshSensorIds(const std::string& caller, bool verbose) {
+    // Read the ns table for all data
+    std::string query = "from(bucket: \"" + bucket_ + "\") "
+        "|> range(start: -50y, stop: 100y)"
+        "|> filter(fn: (r) => r[\"_measurement\"] == \"ns\")";
+    std::string response;
+    queryData2(response, query);
+
+    // Parse the response
+    std::vector<std::unordered_map<std::string,std::string>> parsed_response = parseQueryResponse(response);
+
+    // Collect all the sensor-name and sensor-id pairs that exist in the ns table
+    std::vector<std::pair<std::string, int>> entries;
+    entries.reserve(parsed_response.size());
+    for(const auto& element : parsed_response) {
+        // Check sensor_ and sensor_id_ keys exist (ns table should contain these keys)
+        if(element.find("sensor_") == element.end() || element.find("_value") == element.end()) {
+            std::cerr << "Error in " << caller << " call: "
+            "sensor_ or sensor_id key not found in ns table\n";
+            throw std::runtime_error("Error in " + caller + " call: "
+            "sensor_ or sensor_id key not found in ns table\n");
+        }
+        try {
+            entries.emplace_back(element.at("sensor_"), std::stoi(element.at("_value")));
+        } catch (const std::exception&) {
+            std::cerr << "Warning in " << caller << " call: skipping non-numeric sensor_id for "
+            << element.at("sensor_") << " in ns table\n";
+        }
+    }
+    if(verbose) std::cout << "Read " << entries.size() << " ns entries from bucket: " << bucket_ << "\n";
+
+    SensorRegistry::instance().merge(bucket_, entries);
+}
+
+// Internal resolution of sensor ids through the shared registry; unknown names get new ns rows
+std::vector<int> InfluxDatabase::resolveSensorIds(const std::vector<std::string>& names,
+    const std::string& machine_name, const std::string& caller, bool verbose) {
+    SensorRegistry& registry = SensorRegistry::instance();
+
+    // Warm path: every name is already known locally
+    std::vector<int> ids = registry.lookup(bucket_, names);
+    if (std::find(ids.begin(), ids.end(), -1) == ids.end()) {
+        return ids;
+    }
+
+    // Refresh once from the server before handing out new ids
+    refreshSensorIds(caller, verbose);
+    ids = registry.lookup(bucket_, names);
+    std::vector<std::string> missing;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        if (ids[i] == -1) missing.push_back(names[i]);
+    }
+    if (missing.empty()) {
+        return ids;
+    }
+
+    // Reserve ids for the new names and write their ns rows in one batch
+    std::vector<std::pair<std::string, int>> reserved = registry.reserve(bucket_, missing);
+    std::vector<std::string> ns_rows;
+    ns_rows.reserve(reserved.size());
+    std::unordered_map<std::string, int> reserved_ids;
+    for (const auto& entry : reserved) {
+        if(verbose) std::cout << "No entry found for sensor: " << entry.first << ", registering sensor_id: " << entry.second << "\n";
+        ns_rows.push_back("ns,machine_=" + escapeSpecialChars(machine_name) +
+            ",sensor_=" + escapeSpecialChars(entry.first) +
+            " sensor_id=\"" + std::to_string(entry.second) +
+            "\" " + NS_DEFAULT_TIMESTAMP);
+        reserved_ids.emplace(entry.first, entry.second);
+    }
+    writeBatchData2(ns_rows, verbose);
+    registry.confirm(bucket_, reserved);
+
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        if (ids[i] == -1) ids[i] = reserved_ids.at(names[i]);
+    }
+    return ids;
+}
+
+bool InfluxDatabase::copyEpitrendToBucket(const EpitrendBinaryData& data, bool verbose){
     // Batch size
     const int batchSize = 1000;
     const std::string epitrend_machine_name = "GEN200";
@@ -513,8 +718,7 @@ bool InfluxDatabase::copyEpitrendToBucket(EpitrendBinaryData data, bool verbose)
     };
 
     // Loop through all data
-    std::unordered_map<std::string, std::unordered_map<double,double>> raw_data = data.getAllTimeSeriesData();
-    for(const auto& name_data_map : raw_data) {
+    for(const auto& series : data.getAllSeries()) {
         // CHECK IF PART NAME IS IN NS TABLE
         // IF IT ISN'T
             // ADD ENTRY OF MACHINE NAME AND PART NAME INTO TABLE
@@ -525,14 +729,14 @@ bool InfluxDatabase::copyEpitrendToBucket(EpitrendBinaryData data, bool verbose)
         
         if(verbose)
             std::cout << "--------------------\n Current name: " <<
-            name_data_map.first << "\n";
+            series.name << "\n";
         
         // Set the ns read query
         ns_read_struct ns_read =
         {
             .bucket = bucket_,
             .machine_name = epitrend_machine_name,
-            .sensor_name = name_data_map.first
+            .sensor_name = series.name
         }; 
         ns_read.set_read_query();
         
@@ -548,7 +752,7 @@ bool InfluxDatabase::copyEpitrendToBucket(EpitrendBinaryData data, bool verbose)
 
         // Check if data is found
         if(parsed_response.size() == 0) {
-            if(verbose) std::cout << "No entry found for sensor: " << name_data_map.first << "\n";
+            if(verbose) std::cout << "No entry found for sensor: " << series.name << "\n";
 
             // Set the ns read all data query
             ns_read_all_struct ns_read_all = {.bucket = bucket_};
@@ -587,7 +791,7 @@ bool InfluxDatabase::copyEpitrendToBucket(EpitrendBinaryData data, bool verbose)
 
                 // Get the next sensor_id
                 valid_sensor_id = *std::max_element(sensor_ids.begin(), sensor_ids.end()) + 1;
-                if(verbose) std::cout << "Next sensor_id available for \"" << name_data_map.first <<"\": " << valid_sensor_id << "\n";
+                if(verbose) std::cout << "Next sensor_id available for \"" << series.name <<"\": " << valid_sensor_id << "\n";
 
             }
 
@@ -595,7 +799,7 @@ bool InfluxDatabase::copyEpitrendToBucket(EpitrendBinaryData data, bool verbose)
             ns_write_struct ns_write = 
             {
                 .machine_name = epitrend_machine_name,
-                .sensor_name = name_data_map.first,
+                .sensor_name = series.name,
                 .sensor_id = std::to_string(valid_sensor_id)
             };
             ns_write.set_write_query();
@@ -605,7 +809,7 @@ bool InfluxDatabase::copyEpitrendToBucket(EpitrendBinaryData data, bool verbose)
             writeBatchData2({ns_write.write_query}, verbose);
 
         } else {
-            if(verbose) std::cout << "Entry found for sensor: " << name_data_map.first << "\n";
+            if(verbose) std::cout << "Entry found for sensor: " << series.name << "\n";
             
             // Get the sensor_id
             valid_sensor_id = stoi(parsed_response[0]["_value"]);
@@ -621,10 +825,10 @@ bool InfluxDatabase::copyEpitrendToBucket(EpitrendBinaryData data, bool verbose)
 
         // Loop through all the time-value pairs for the current name
         std::vector<std::string> batch_data;
-        for (const auto& time_value : name_data_map.second) {
+        for (std::size_t k = 0; k < series.samples.size(); ++k) {
             // Prepare the ts write query
-            ts_write.num = std::to_string(time_value.second);
-            ts_write.timestamp = std::to_string(convertDaysFromEpochToPrecisionFromUnix(time_value.first));
+            ts_write.num = std::to_string(series.samples.values[k]);
+            ts_write.timestamp = std::to_string(convertDaysFromEpochToPrecisionFromUnix(series.samples.times[k]));
             ts_write.set_write_query();
             
             // Batch the data
@@ -648,496 +852,146 @@ bool InfluxDatabase::copyEpitrendToBucket(EpitrendBinaryData data, bool verbose)
     return true;
 }
 
-bool InfluxDatabase::copyEpitrendToBucket2(EpitrendBinaryData data, bool verbose){
-    // Batch size
-    const int batchSize = 5000;
-
-    // Number of retry calls
-    const int retryCalls = 5;
-
-    const std::string epitrend_machine_name = "GEN200";
-
-    // Prepare time-series (ts) query write statement e.g.
-    //measurement + ",sensor_id_=1 num=299i 1735728000000";
-    struct ts_write_struct {
-        std::string sensor_id;
-        std::string num;  // MUST BE A DECIMAL
-        std::string timestamp;
-        std::string write_query;
-        void set_write_query(){write_query ="ts,sensor_id_=" + 
-            sensor_id + " num=" + 
-            num + " " + timestamp;
-        }
-    };
-
-    // Prepare name-series (ns) query write statement e.g.
-    //measurement + ",machine_=\"machine.name.2\",sensor_=\"sensor.name.2\" sensor_id=\"4\" " + std::to_string(default_ns_timestamp);
-    struct ns_write_struct {
-        std::string machine_name;
-        std::string sensor_name;
-        std::string sensor_id;
-        std::string default_timestamp = "2000000000000";
-        std::string write_query;
-        void set_write_query(){write_query = "ns,machine_=" + escapeSpecialChars(machine_name) + 
-            ",sensor_=" + escapeSpecialChars(sensor_name) + 
-            " sensor_id=\"" + sensor_id + 
-            "\" " + default_timestamp;
-        }
-    };
+bool InfluxDatabase::copyEpitrendToBucket2(const EpitrendBinaryData& data, bool verbose){
+    std::vector<EncodedBatch> batches = encodeBatches(data, verbose);
+    sendBatches(batches, verbose);
+    return true;
+}
 
-    // Prepare name-series (ns) query read statement
-    //     "from(bucket: \"test-bucket\")"
-    //   "|> range(start: -100y, stop: 50y)"
-    //   "|> filter(fn: (r) => r[\"_measurement\"] == \"ns\")"
-    ;
-    struct ns_read_struct {
-        std::string bucket;
-        std::string machine_name;
-        std::string sensor_name;
-        std::string read_query;
-        void set_read_query(){read_query = "from(bucket: \"" + bucket + "\") "
-            "|> range(start: -50y, stop: 100y)"
-            "|> filter(fn: (r) => r[\"_measurement\"] == \"ns\")" 
-            "|> filter(fn: (r) => r[\"sensor_\"] == \"" + sensor_name + "\")"
-            "|> filter(fn: (r) => r[\"machine_\"] == \"" + machine_name + "\")";
-        }
-    };
+bool InfluxDatabase::copyRGADataToBucket(const RGAData& data, bool verbose) {
+    std::vector<EncodedBatch> batches = encodeBatches(data, verbose);
+    sendBatches(batches, verbose);
+    return true;
+}
 
-    // Prepare name-series (ns) query read all data statement
-    struct ns_read_all_struct {
-        std::string bucket;
-        std::string read_query;
-        void set_read_query(){read_query = "from(bucket: \"" + bucket + "\") "
-            "|> range(start: -50y, stop: 100y)"
-            "|> filter(fn: (r) => r[\"_measurement\"] == \"ns\")";
-        }
+template <typename Series, typename ToTimestamp>
+std::vector<InfluxDatabase::EncodedBatch> InfluxDatabase::encodeSeries(const std::vector<Series>& all_series,
+    const std::vector<int>& sensor_ids, ToTimestamp to_timestamp, bool float_precision,
+    std::size_t first, std::size_t count, bool split) {
+    // The sink compresses the merged bodies, so its ratio tells the bytes a batch will cost
+    const double ratio = gzip_ ? SharedSink::instance().compressionRatio(sinkDestination()) : 1.0;
+
+    std::vector<EncodedBatch> batches;
+    LineProtocolEncoder encoder;
+    std::size_t next = first; // Index of the next sample over all series
+    auto close_batch = [&] {
+        EncodedBatch batch;
+        batch.points = encoder.pointCount();
+        batch.first = next - batch.points;
+        batch.sensorIds = encoder.sensorIds();
+        batch.lines = encoder.take();
+        batches.push_back(std::move(batch));
     };
-
-    // Set the ns read all data query
-    ns_read_all_struct ns_read_all = {.bucket = bucket_};
-    ns_read_all.set_read_query();
-
-    // Read the ns table for all data
-    std::string response;
-    response = "";
-    queryData2(response, ns_read_all.read_query);
-
-    // Parse the response
-    std::vector<std::unordered_map<std::string,std::string>> parsed_response = parseQueryResponse(response);
-
-    // Cache all the sensor-name and sensor-id pairs that exist in the ns table
-    std::unordered_map<std::string, std::string> sensor_names_to_ids;
-    for(const auto& element : parsed_response) {
-        // Check sensor_ and sensor_id_ keys exist (ns table should contain these keys)
-        if(element.find("sensor_") == element.end() || element.find("_value") == element.end()) {
-            std::cerr << "Error in InfluxDatabase::copyEpitrendToBucket2 call: "
-            "sensor_ or sensor_id key not found in ns table\n";
-            throw std::runtime_error("Error in InfluxDatabase::copyEpitrendToBucket2 call: "
-            "sensor_ or sensor_id key not found in ns table\n");
+    const std::size_t end = count > std::numeric_limits<std::size_t>::max() - first
+        ? std::numeric_limits<std::size_t>::max() : first + count;
+    std::size_t base = 0; // Index of the first sample of the current series
+    for (std::size_t s = 0; s < all_series.size() && base < end; ++s) {
+        const auto& samples = all_series[s].samples;
+        const std::size_t from = first > base ? std::min(first - base, samples.size()) : 0;
+        const std::size_t to = std::min(end - base, samples.size());
+        for (std::size_t k = from; k < to; ++k) {
+            encoder.appendTsPoint(sensor_ids[s], samples.values[k], to_timestamp(samples.times[k]), float_precision);
+            ++next;
+            if (split && batcher_.overLimit(encoder.pointCount(), static_cast<std::size_t>(static_cast<double>(encoder.size()) * ratio))) {
+                close_batch();
+            }
         }
-
-        // Cache the sensor-name and sensor-id pairs
-        sensor_names_to_ids[element.at("sensor_")] = element.at("_value");
-        //std::cout << "Cached sensor-name: " << element.at("sensor_") << " with sensor-id: " << element.at("_value") << "\n";
+        base += samples.size();
     }
+    if (!encoder.empty()) {
+        close_batch();
+    }
+    return batches;
+}
 
-    // Loop through all data
-    std::unordered_map<std::string, std::unordered_map<double,double>> raw_data = data.getAllTimeSeriesData();
-    std::vector<std::string> batch_data;
-
-    for(const auto& name_data_map : raw_data) {
-        // CHECK IF PART NAME IS IN NS TABLE
-        // IF IT ISN'T
-            // ADD ENTRY OF MACHINE NAME AND PART NAME INTO TABLE
-            // GET NEW SENSOR_ID FOR NAME AND ALSO INTO TABLE
-        // IF IT IS
-            // GET THE SENSOR_ID
-        // ENTER ALL ASSOCIATED DATA INTO TS TABLE WITH ASSOCIATE SENSOR ID
-        
-        if(verbose)
-            std::cout << "--------------------\n Current name: " <<
-            name_data_map.first << "\n";
-
-        // Prepare the sensor id associated with the current sensor name
-        int valid_sensor_id = -1;
-
-        // Check if sensor_ name exists in the ns table
-        int found_sensor_name_in_ns = 
-            !(sensor_names_to_ids.find(escapeSpecialChars(name_data_map.first)) == sensor_names_to_ids.end());
-
-        // Check if data is found
-        if(!found_sensor_name_in_ns) {
-            if(verbose) std::cout << "No entry found for sensor: " << name_data_map.first << "\n";
-
-            // Check if cache is empty to prevent segmentation faults
-            if (sensor_names_to_ids.empty()) {
-                // Manually set first sensor id since there no data found within the name-series (ns). New table?
-                if(verbose) std::cerr << "Warning in InfluxDatabase::copyEpitrendToBucket call: "
-                "no data found in ns table.\n";
-                valid_sensor_id = 1;
-
-            } else {
-                // Get the next sensor_id
-                valid_sensor_id = std::stoi(std::max_element(sensor_names_to_ids.begin(), sensor_names_to_ids.end(),
-                    [](const auto& a, const auto& b) {
-                        return std::stoi(a.second) < std::stoi(b.second);
-                    })->second) + 1;
-
-                if(verbose) std::cout << "Next sensor_id available for \"" << name_data_map.first <<"\": " << valid_sensor_id << "\n";
-
-            }
-
-            // Set the ns write query
-            ns_write_struct ns_write = 
-            {
-                .machine_name = epitrend_machine_name,
-                .sensor_name = name_data_map.first,
-                .sensor_id = std::to_string(valid_sensor_id)
-            };
-            ns_write.set_write_query();
-            if(verbose) std::cout << "Write query: " << ns_write.write_query << "\n";
-
-            // Write the new sensor_id with the machine and sensor name into ns
-            writeBatchData2({ns_write.write_query}, verbose);
-
-            // Update the cache
-            sensor_names_to_ids[name_data_map.first] = std::to_string(valid_sensor_id);
-
-        } else {
-            if(verbose) std::cout << "Entry found for sensor: " << name_data_map.first << "\n";
-
-            // Get the sensor_id
-            valid_sensor_id = std::stoi(sensor_names_to_ids.at(name_data_map.first));
-            if(verbose) std::cout << "Sensor_id: " << valid_sensor_id << "\n";
-
-        }
+std::vector<InfluxDatabase::EncodedBatch> InfluxDatabase::encodeRange(const EpitrendBinaryData& data,
+    std::size_t first, std::size_t count, bool split, bool verbose) {
+    std::vector<std::string> sensor_names;
+    sensor_names.reserve(data.getAllSeries().size());
+    for (const auto& series : data.getAllSeries()) {
+        sensor_names.push_back(series.name);
+    }
+    std::vector<int> sensor_ids;
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex_);
+        sensor_ids = resolveSensorIds(sensor_names, "GEN200", "InfluxDatabase::encodeBatches", verbose);
+    }
 
-        // Prepare ts query write statement
-        ts_write_struct ts_write = 
-        {
-            .sensor_id = std::to_string(valid_sensor_id),
-        };
+    return encodeSeries(data.getAllSeries(), sensor_ids, [this](double days) {
+        return convertDaysFromEpochToPrecisionFromUnix(days);
+    }, epitrendFloatPrecision_, first, count, split);
+}
 
-        // Loop through all the time-value pairs for the current name
-        for (const auto& time_value : name_data_map.second) {
-            // Prepare the ts write query
-            std::ostringstream num_stream;
-            num_stream << std::setprecision(15) << time_value.second;
-            ts_write.num = num_stream.str();
+std::vector<InfluxDatabase::EncodedBatch> InfluxDatabase::encodeRange(const RGAData& data,
+    std::size_t first, std::size_t count, bool split, bool verbose) {
+    RGAData::BinRegistry& registry = RGAData::BinRegistry::instance();
+    std::vector<std::string> sensor_names;
+    sensor_names.reserve(data.getAllSeries().size());
+    for (const auto& series : data.getAllSeries()) {
+        sensor_names.push_back("RGA." + registry.name(series.id));
+    }
+    std::vector<int> sensor_ids;
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex_);
+        sensor_ids = resolveSensorIds(sensor_names, "GEN200_RGA", "InfluxDatabase::encodeBatches", verbose);
+    }
 
-            std::ostringstream timestamp_stream;
-            timestamp_stream << std::setprecision(15) << convertDaysFromEpochToPrecisionFromUnix(time_value.first);
-            ts_write.timestamp = timestamp_stream.str();
+    return encodeSeries(data.getAllSeries(), sensor_ids, [this](double seconds) {
+        return convertSecondsFromUnixToPrecisionFromUnix(seconds);
+    }, false, first, count, split);
+}
 
-            ts_write.set_write_query();
-            
-            // Batch the data
-            batch_data.push_back(ts_write.write_query);
+std::vector<InfluxDatabase::EncodedBatch> InfluxDatabase::encodeBatches(const EpitrendBinaryData& data, bool verbose) {
+    return encodeRange(data, 0, std::numeric_limits<std::size_t>::max(), true, verbose);
+}
 
-            if(batch_data.size() >= batchSize) {
-                // Write the time-value pair to the ts table
-                if(verbose) std::cout << "Writing batch data...\n";
-                
-                for(int i = 0; i < retryCalls; i++){
-                    try {
-                        writeBatchData2(batch_data, false);
-                        break;
-                    } catch (std::exception& e) {
-                        if(verbose) std::cerr << "Error in InfluxDatabase::copyEpitrendToBucket2 call: error writing to ts table\n";
-                        if(verbose) std::cerr << "Error message: " << e.what() << "\n";
-                        if(verbose) std::cerr << "Retrying...\n";
-                        if (i == 9) {
-                            if(verbose) std::cerr << "Error in InfluxDatabase::copyEpitrendToBucket2 call: failed to write to ts table after " << retryCalls << " attempts\n";
-                            throw std::runtime_error("Error in InfluxDatabase::copyEpitrendToBucket2 call: failed to write to ts table\n");
-                        }
-                        std::this_thread::sleep_for(std::chrono::seconds(1));
+std::vector<InfluxDatabase::EncodedBatch> InfluxDatabase::encodeBatches(const RGAData& data, bool verbose) {
+    return encodeRange(data, 0, std::numeric_limits<std::size_t>::max(), true, verbose);
+}
 
-                    }
-                }
-                // writeBatchData2(batch_data, false);
-                batch_data.clear();
-            }
-        }
-        
+void InfluxDatabase::encodeAgain(const EpitrendBinaryData& data, EncodedBatch& batch, bool verbose) {
+    if (batch.lines.empty() && batch.points > 0) {
+        batch.lines = std::move(encodeRange(data, batch.first, batch.points, false, verbose).front().lines);
     }
+}
 
-    // Write the remaining data
-    if(batch_data.size() > 0) {
-        if(verbose) std::cout << "Writing batch data...\n";
-
-        for(int i = 0; i < retryCalls; i++){
-            try {
-                writeBatchData2(batch_data, false);
-                break;
-            } catch (std::exception& e) {
-                if(verbose) std::cerr << "Error in InfluxDatabase::copyEpitrendToBucket2 call: error writing remaining data to ts table\n";
-                if(verbose) std::cerr << "Error message: " << e.what() << "\n";
-                if(verbose) std::cerr << "Batch size is: " << batch_data.size() << "\n";
-                if(verbose) std::cerr << "Retrying...\n";
-                if (i == 9) {
-                    if(verbose) std::cerr << "Error in InfluxDatabase::copyEpitrendToBucket2 call: failed to write to ts table after " << retryCalls << " attempts\n";
-                    throw std::runtime_error("Error in InfluxDatabase::copyEpitrendToBucket2 call: failed to write to ts table\n");
-                }
-                std::this_thread::sleep_for(std::chrono::seconds(1));
-
-            }
-        }
-        // writeBatchData2(batch_data, verbose);
+void InfluxDatabase::encodeAgain(const RGAData& data, EncodedBatch& batch, bool verbose) {
+    if (batch.lines.empty() && batch.points > 0) {
+        batch.lines = std::move(encodeRange(data, batch.first, batch.points, false, verbose).front().lines);
     }
-
-    return true;
 }
 
-bool InfluxDatabase::copyRGADataToBucket(RGAData data, bool verbose) {
-    // Batch size
-    const int batchSize = 5000;
-
+void InfluxDatabase::sendBatches(std::vector<EncodedBatch>& batches, bool verbose) {
     // Number of retry calls
     const int retryCalls = 5;
 
-    const std::string epitrend_machine_name = "GEN200_RGA";
-
-
-    // Prepare time-series (ts) query write statement e.g.
-    //measurement + ",sensor_id_=1 num=299i 1735728000000";
-    struct ts_write_struct {
-        std::string sensor_id;
-        std::string num;  // MUST BE A DECIMAL
-        std::string timestamp;
-        std::string write_query;
-        void set_write_query(){write_query ="ts,sensor_id_=" + 
-            sensor_id + " num=" + 
-            num + " " + timestamp;
-        }
-    };
-
-    // Prepare name-series (ns) query write statement e.g.
-    //measurement + ",machine_=\"machine.name.2\",sensor_=\"sensor.name.2\" sensor_id=\"4\" " + std::to_string(default_ns_timestamp);
-    struct ns_write_struct {
-        std::string machine_name;
-        std::string sensor_name;
-        std::string sensor_id;
-        std::string default_timestamp = "2000000000000";
-        std::string write_query;
-        void set_write_query(){write_query = "ns,machine_=" + escapeSpecialChars(machine_name) + 
-            ",sensor_=" + escapeSpecialChars(sensor_name) + 
-            " sensor_id=\"" + sensor_id + 
-            "\" " + default_timestamp;
-        }
-    };
-
-    // Prepare name-series (ns) query read statement
-    //     "from(bucket: \"test-bucket\")"
-    //   "|> range(start: -100y, stop: 50y)"
-    //   "|> filter(fn: (r) => r[\"_measurement\"] == \"ns\")"
-    ;
-    struct ns_read_struct {
-        std::string bucket;
-        std::string machine_name;
-        std::string sensor_name;
-        std::string read_query;
-        void set_read_query(){read_query = "from(bucket: \"" + bucket + "\") "
-            "|> range(start: -50y, stop: 100y)"
-            "|> filter(fn: (r) => r[\"_measurement\"] == \"ns\")" 
-            "|> filter(fn: (r) => r[\"sensor_\"] == \"" + sensor_name + "\")"
-            "|> filter(fn: (r) => r[\"machine_\"] == \"" + machine_name + "\")";
-        }
-    };
-
-    // Prepare name-series (ns) query read all data statement
-    struct ns_read_all_struct {
-        std::string bucket;
-        std::string read_query;
-        void set_read_query(){read_query = "from(bucket: \"" + bucket + "\") "
-            "|> range(start: -50y, stop: 100y)"
-            "|> filter(fn: (r) => r[\"_measurement\"] == \"ns\")";
-        }
-    };
-
-    // Set the ns read all data query
-    ns_read_all_struct ns_read_all = {.bucket = bucket_};
-    ns_read_all.set_read_query();
-
-    // Read the ns table for all data
-    std::string response;
-    response = "";
-    queryData2(response, ns_read_all.read_query);
-
-    // Parse the response
-    std::vector<std::unordered_map<std::string,std::string>> parsed_response = parseQueryResponse(response);
-
-    // Cache all the sensor-name and sensor-id pairs that exist in the ns table
-    std::unordered_map<std::string, std::string> sensor_names_to_ids;
-    for(const auto& element : parsed_response) {
-        // Check sensor_ and sensor_id_ keys exist (ns table should contain these keys)
-        if(element.find("sensor_") == element.end() || element.find("_value") == element.end()) {
-            std::cerr << "Error in InfluxDatabase::copyEpitrendToBucket2 call: "
-            "sensor_ or sensor_id key not found as an entry into ns table\n";
-            throw std::runtime_error("Error in InfluxDatabase::copyEpitrendToBucket2 call: "
-            "sensor_ or sensor_id key not found as an entry into ns table\n");
-        }
-
-        // Cache the sensor-name and sensor-id pairs
-        sensor_names_to_ids[element.at("sensor_")] = element.at("_value");
-        //std::cout << "Cached sensor-name: " << element.at("sensor_") << " with sensor-id: " << element.at("_value") << "\n";
-    }
-
-    // Loop through all data
-    const auto& raw_data = data.getAllTimeSeriesData();
-    std::vector<std::string> batch_data;
-
-    for(const auto& name_data_map : raw_data) {
-        // CHECK IF PART NAME IS IN NS TABLE
-        // IF IT ISN'T
-            // ADD ENTRY OF MACHINE NAME AND PART NAME INTO TABLE
-            // GET NEW SENSOR_ID FOR NAME AND ALSO INTO TABLE
-        // IF IT IS
-            // GET THE SENSOR_ID
-        // ENTER ALL ASSOCIATED DATA INTO TS TABLE WITH ASSOCIATE SENSOR ID
-        
-        std::string name = "RGA." + name_data_map.first.binsString();
-
-        if(verbose)
-            std::cout << "--------------------\n Current name: " <<
-            name << "\n";
-
-        // Prepare the sensor id associated with the current sensor name
-        int valid_sensor_id = -1;
-
-        // Check if sensor_ name exists in the ns table
-        int found_sensor_name_in_ns = 
-            !(sensor_names_to_ids.find(escapeSpecialChars(name)) == sensor_names_to_ids.end());
-
-        // Check if data is found
-        if(!found_sensor_name_in_ns) {
-            if(verbose) std::cout << "No entry found for sensor: " << name << "\n";
-
-            // Check if cache is empty to prevent segmentation faults
-            if (sensor_names_to_ids.empty()) {
-                // Manually set first sensor id since there no data found within the name-series (ns). New table?
-                if(verbose) std::cerr << "Warning in InfluxDatabase::copyEpitrendToBucket call: "
-                "no data found in ns table.\n";
-                valid_sensor_id = 1;
-
-            } else {
-                // Get the next sensor_id
-                valid_sensor_id = std::stoi(std::max_element(sensor_names_to_ids.begin(), sensor_names_to_ids.end(),
-                    [](const auto& a, const auto& b) {
-                        return std::stoi(a.second) < std::stoi(b.second);
-                    })->second) + 1;
-
-                if(verbose) std::cout << "Next sensor_id available for \"" << name <<"\": " << valid_sensor_id << "\n";
-
-            }
-
-            // Set the ns write query
-            ns_write_struct ns_write = 
-            {
-                .machine_name = epitrend_machine_name,
-                .sensor_name = name,
-                .sensor_id = std::to_string(valid_sensor_id)
-            };
-            ns_write.set_write_query();
-            if(verbose) std::cout << "Write query: " << ns_write.write_query << "\n";
-
-            // Write the new sensor_id with the machine and sensor name into ns
-            writeBatchData2({ns_write.write_query}, verbose);
-
-            // Update the cache
-            sensor_names_to_ids[escapeSpecialChars(name)] = std::to_string(valid_sensor_id);
-
-        } else {
-            if(verbose) std::cout << "Entry found for sensor: " << name << "\n";
-
-            // Get the sensor_id
-            valid_sensor_id = std::stoi(sensor_names_to_ids.at(name));
-            if(verbose) std::cout << "Sensor_id: " << valid_sensor_id << "\n";
-
-        }
-
-        // Prepare ts query write statement
-        ts_write_struct ts_write = 
-        {
-            .sensor_id = std::to_string(valid_sensor_id),
-        };
-
-        // Define the stringstream for precision
-        std::ostringstream timestamp_stream;
-        timestamp_stream.precision(15);
-        timestamp_stream << std::fixed;
-        std::ostringstream num_stream;
-        num_stream.precision(15);
-        num_stream << std::fixed;
-
-        // Loop through all the time-value pairs for the current name
-        for (const auto& time_value : name_data_map.second) {
-            // Prepare the ts write query
-            num_stream.str("");
-            num_stream << time_value.second;
-            ts_write.num = num_stream.str();
-
-            timestamp_stream.str("");
-            timestamp_stream << convertSecondsFromUnixToPrecisionFromUnix(time_value.first);
-            ts_write.timestamp = timestamp_stream.str();
-
-            ts_write.set_write_query();
-            
-            // Batch the data
-            batch_data.push_back(ts_write.write_query);
-
-            // Print query
-            //if(verbose) std::cout << "Query: " << ts_write.write_query << "\n";
-
-            if(batch_data.size() >= batchSize) {
-                // Write the time-value pair to the ts table
-                if(verbose) std::cout << "Writing batch data...\n";
-                
-                for(int i = 0; i < retryCalls; i++){
-                    try {
-                        writeBatchData2(batch_data, false);
-                        break;
-                    } catch (std::exception& e) {
-                        if(verbose) std::cerr << "Error in InfluxDatabase::copyEpitrendToBucket2 call: error writing to ts table\n";
-                        if(verbose) std::cerr << "Error message: " << e.what() << "\n";
-                        if(verbose) std::cerr << "Retrying...\n";
-                        if (i == 9) {
-                            if(verbose) std::cerr << "Error in InfluxDatabase::copyEpitrendToBucket2 call: failed to write to ts table after " << retryCalls << " attempts\n";
-                            throw std::runtime_error("Error in InfluxDatabase::copyEpitrendToBucket2 call: failed to write to ts table\n");
-                        }
-                        std::this_thread::sleep_for(std::chrono::seconds(1));
-
-                    }
-                }
-                // writeBatchData2(batch_data, false);
-                batch_data.clear();
-            }
+    // Every batch is in flight at once, up to the in-flight limit of the sink
+    std::vector<std::future<void>> pending_writes;
+    pending_writes.reserve(batches.size());
+    for (EncodedBatch& batch : batches) {
+        if(verbose) std::cout << "Writing batch data...\n";
+        // The lines move on to the sink; the batch keeps its sensor ids and sample range. A batch
+        // that cannot be submitted fails like a refused one, so the batches before it are kept as sent
+        try {
+            pending_writes.push_back(submitBatch(std::exchange(batch.lines, std::string()), batch.sensorIds, retryCalls));
+        } catch (...) {
+            std::promise<void> refused;
+            refused.set_exception(std::current_exception());
+            pending_writes.push_back(refused.get_future());
         }
-        
     }
 
-    // Write the remaining data
-    if(batch_data.size() > 0) {
-        if(verbose) std::cout << "Writing batch data...\n";
-
-        for(int i = 0; i < retryCalls; i++){
-            try {
-                writeBatchData2(batch_data, false);
-                break;
-            } catch (std::exception& e) {
-                if(verbose) std::cerr << "Error in InfluxDatabase::copyEpitrendToBucket2 call: error writing remaining data to ts table\n";
-                if(verbose) std::cerr << "Error message: " << e.what() << "\n";
-                if(verbose) std::cerr << "Batch size is: " << batch_data.size() << "\n";
-                if(verbose) std::cerr << "Retrying...\n";
-                if (i == 9) {
-                    if(verbose) std::cerr << "Error in InfluxDatabase::copyEpitrendToBucket2 call: failed to write to ts table after " << retryCalls << " attempts\n";
-                    throw std::runtime_error("Error in InfluxDatabase::copyEpitrendToBucket2 call: failed to write to ts table\n");
-                }
-                std::this_thread::sleep_for(std::chrono::seconds(1));
-
-            }
+    // Wait until the server has accepted every batch; only the failed ones are kept for a retry
+    std::vector<std::size_t> failed;
+    try {
+        waitForWrites(pending_writes, failed, "InfluxDatabase::sendBatches", verbose);
+    } catch (...) {
+        std::vector<EncodedBatch> unsent;
+        unsent.reserve(failed.size());
+        for (std::size_t index : failed) {
+            unsent.push_back(std::move(batches[index]));
         }
-        // writeBatchData2(batch_data, verbose);
+        batches = std::move(unsent);
+        throw;
     }
-
-    return true;
 }
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "IngestLedger.hpp"
+
+#include <zlib.h>
+
+IngestLedger& IngestLedger::instance() {
+    static IngestLedger ledger;
+    return ledger;
+}
+
+void IngestLedger::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file.is_open()) {
+        file.close();
+    }
+    ledgerPath = path;
+    entries.clear();
+
+    // Load the entries written by earlier runs; a later line for the same path wins
+    std::ifstream existing(ledgerPath);
+    std::string line;
+    while (std::getline(existing, line)) {
+        std::istringstream fields(line);
+        std::string size, mtime, hash, points, watermark, source;
+        std::getline(fields, size, '\t');
+        std::getline(fields, mtime, '\t');
+        std::getline(fields, hash, '\t');
+        std::getline(fields, points, '\t');
+        std::getline(fields, watermark, '\t');
+        std::getline(fields, source);
+        try {
+            if (source.empty()) {
+                throw std::invalid_argument("no path");
+            }
+            LedgerEntry entry;
+            entry.size = std::stoull(size);
+            entry.mtime = std::stoll(mtime);
+            entry.hash = static_cast<std::uint32_t>(std::stoul(hash));
+            entry.points = std::stoull(points);
+            entry.watermark = std::stod(watermark);
+            entries[source] = entry;
+        } catch (const std::exception&) {
+            // A line cut short by a crash is ignored; its file is loaded again
+            std::cerr << "Warning in IngestLedger::open call: skipping malformed line in " << ledgerPath << "\n";
+        }
+    }
+    existing.close();
+
+    // Compact to one line per file, replaced in one rename
+    const std::string temporary = ledgerPath + ".tmp";
+    file.open(temporary, std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error in IngestLedger::open call: Could not open file: " + temporary);
+    }
+    for (const auto& [source, entry] : entries) {
+        append(source, entry);
+    }
+    file.close();
+    std::error_code error;
+    std::filesystem::rename(temporary, ledgerPath, error);
+    if (error) {
+        throw std::runtime_error("Error in IngestLedger::open call: Could not replace " + ledgerPath + ": " + error.message());
+    }
+
+    file.open(ledgerPath, std::ios::app);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error in IngestLedger::open call: Could not open file: " + ledgerPath);
+    }
+}
+
+IngestLedger::Plan IngestLedger::plan(const std::string& path, LedgerEntry& observed) {
+    std::error_code error;
+    observed = LedgerEntry();
+    observed.size = std::filesystem::file_size(path, error);
+    const auto time = std::filesystem::last_write_time(path, error);
+    if (error) {
+        return Plan::Load; // Let the parse report the missing file
+    }
+    observed.mtime = static_cast<std::int64_t>(time.time_since_epoch().count());
+
+    LedgerEntry recorded;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(path);
+        if (it == entries.end()) {
+            observed.hash = fingerprint(path, observed.size);
+            return Plan::Load;
+        }
+        recorded = it->second;
+    }
+    if (recorded.size == observed.size && recorded.mtime == observed.mtime) {
+        observed = recorded;
+        return Plan::Skip;
+    }
+
+    // Touched or copied without a change of content: remember the new mtime
+    observed.hash = fingerprint(path, observed.size);
+    if (recorded.size == observed.size && recorded.hash == observed.hash) {
+        const std::int64_t mtime = observed.mtime;
+        observed = recorded;
+        observed.mtime = mtime;
+        record(path, observed);
+        return Plan::Skip;
+    }
+
+    // Appended to: what was acknowledged before still is
+    if (observed.size > recorded.size) {
+        observed.points = recorded.points;
+        observed.watermark = recorded.watermark;
+        return Plan::Resume;
+    }
+    return Plan::Load;
+}
+
+bool IngestLedger::unchanged(const std::string& path, std::uintmax_t size, std::int64_t mtime) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(path);
+    return it != entries.end() && it->second.size == size && it->second.mtime == mtime;
+}
+
+void IngestLedger::record(const std::string& path, const LedgerEntry& observed) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[path] = observed;
+    if (file.is_open()) {
+        append(path, observed);
+        file.flush();
+    }
+}
+
+std::uint32_t IngestLedger::fingerprint(const std::string& path, std::uintmax_t size) {
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, reinterpret_cast<const Bytef*>(&size), sizeof(size));
+
+    std::ifstream input(path, std::ios::binary);
+    if (!input.is_open()) {
+        return static_cast<std::uint32_t>(crc);
+    }
+    std::vector<char> block(FINGERPRINT_BLOCK);
+    input.read(block.data(), static_cast<std::streamsize>(block.size()));
+    crc = crc32(crc, reinterpret_cast<const Bytef*>(block.data()), static_cast<uInt>(input.gcount()));
+    if (size > FINGERPRINT_BLOCK) {
+        input.clear();
+        input.seekg(static_cast<std::streamoff>(std::max<std::uintmax_t>(FINGERPRINT_BLOCK, size - FINGERPRINT_BLOCK)));
+        input.read(block.data(), static_cast<std::streamsize>(block.size()));
+        crc = crc32(crc, reinterpret_cast<const Bytef*>(block.data()), static_cast<uInt>(input.gcount()));
+    }
+    return static_cast<std::uint32_t>(crc);
+}
+
+// Caller holds the mutex
+void IngestLedger::append(const std::string& path, const LedgerEntry& entry) {
+    file << entry.size << "\t" << entry.mtime << "\t" << entry.hash << "\t" << entry.points << "\t"
+         << std::setprecision(17) << entry.watermark << "\t" << path << "\n";
+}
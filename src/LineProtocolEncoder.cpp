@@ -0,0 +1,67 @@
+#include "LineProtocolEncoder.hpp"
+
+#include <charconv>
+
+LineProtocolEncoder::LineProtocolEncoder(std::size_t reserve_bytes) : reserveBytes(reserve_bytes) {
+    body.reserve(reserve_bytes);
+}
+
+bool LineProtocolEncoder::appendTsPoint(int sensor_id, double value, long long timestamp, bool float_precision) {
+    if (!std::isfinite(value)) {
+        return false;
+    }
+    if (sensors.empty() || sensors.back() != sensor_id) {
+        sensors.push_back(sensor_id);
+    }
+    static const char prefix[] = "ts,sensor_id_=";
+    body.append(prefix, sizeof(prefix) - 1);
+    appendInteger(sensor_id);
+    body.append(" num=", 5);
+    if (float_precision) {
+        appendFloat(static_cast<float>(value));
+    } else {
+        appendDouble(value);
+    }
+    body.push_back(' ');
+    appendInteger(timestamp);
+    endLine();
+    return true;
+}
+
+void LineProtocolEncoder::appendInteger(long long value) {
+    char digits[24];
+    std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+    body.append(digits, static_cast<std::size_t>(result.ptr - digits));
+}
+
+void LineProtocolEncoder::appendDouble(double value) {
+    char digits[32];
+    std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+    body.append(digits, static_cast<std::size_t>(result.ptr - digits));
+}
+
+void LineProtocolEncoder::appendFloat(float value) {
+    char digits[24];
+    std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+    body.append(digits, static_cast<std::size_t>(result.ptr - digits));
+}
+
+void LineProtocolEncoder::endLine() {
+    body.push_back('\n');
+    ++points;
+}
+
+void LineProtocolEncoder::clear() {
+    body.clear();
+    points = 0;
+    sensors.clear();
+}
+
+std::string LineProtocolEncoder::take() {
+    std::string taken;
+    taken.swap(body);
+    body.reserve(reserveBytes);
+    points = 0;
+    sensors.clear();
+    return taken;
+}
@@ -0,0 +1,70 @@
+#include "MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Error in MappedFile constructor: Could not open file: " + path);
+    }
+
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Error in MappedFile constructor: Could not stat file: " + path);
+    }
+
+    // Empty files cannot be mapped but are still valid (zero-length) views
+    size_ = static_cast<std::size_t>(file_stat.st_size);
+    if (size_ > 0) {
+        void* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Error in MappedFile constructor: Could not map file: " + path);
+        }
+        data_ = static_cast<const char*>(mapped);
+
+        // Whole-file sequential decode, so let the kernel read ahead aggressively
+        ::madvise(mapped, size_, MADV_SEQUENTIAL);
+    }
+
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+    isOpen_ = true;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(other.data_), size_(other.size_), isOpen_(other.isOpen_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.isOpen_ = false;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = other.data_;
+        size_ = other.size_;
+        isOpen_ = other.isOpen_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.isOpen_ = false;
+    }
+    return *this;
+}
+
+void MappedFile::close() {
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    isOpen_ = false;
+}
@@ -0,0 +1,109 @@
+#include "RGABinKernel.hpp"
+
+RGABinKernel::RGABinKernel(const std::vector<double>& amus, const std::vector<RGAData::BinId>& bins, bool verbose)
+    : columns(amus.size()) {
+    // Header labels carry two decimals, so match bins to columns in hundredths of an AMU
+    std::unordered_map<long long, std::uint32_t> column_by_amu;
+    for (std::size_t j = 0; j < amus.size(); ++j) {
+        column_by_amu.emplace(std::llround(amus[j] * 100.0), static_cast<std::uint32_t>(j));
+    }
+
+    runOffsets.reserve(bins.size() + 1);
+    runOffsets.push_back(0);
+    inverseCount.reserve(bins.size());
+    std::vector<std::uint32_t> bin_columns;
+    RGAData::BinRegistry& registry = RGAData::BinRegistry::instance();
+    for (RGAData::BinId id : bins) {
+        // Resolve the columns of the bin values once
+        bin_columns.clear();
+        for (const auto& bin : registry.bins(id).bins) {
+            auto column = column_by_amu.find(std::llround(bin * 100.0));
+            if (column == column_by_amu.end()) {
+                if (verbose) std::cerr << "Warning in RGABinKernel constructor: bin value " << std::fixed << std::setprecision(2) << bin
+                << std::defaultfloat << " not found in header... excluding this value from the average.\n";
+                continue;
+            }
+            bin_columns.push_back(column->second);
+        }
+        std::sort(bin_columns.begin(), bin_columns.end());
+        bin_columns.erase(std::unique(bin_columns.begin(), bin_columns.end()), bin_columns.end());
+
+        // Collapse consecutive columns into runs; a sorted header gives one run per bin
+        for (std::size_t k = 0; k < bin_columns.size(); ++k) {
+            if (k == 0 || bin_columns[k] != bin_columns[k - 1] + 1) {
+                runBegin.push_back(bin_columns[k]);
+                runEnd.push_back(bin_columns[k] + 1);
+            } else {
+                runEnd.back() = bin_columns[k] + 1;
+            }
+        }
+        runOffsets.push_back(static_cast<std::uint32_t>(runBegin.size()));
+        inverseCount.push_back(bin_columns.empty() ? 0.0 : 1.0 / static_cast<double>(bin_columns.size()));
+    }
+}
+
+void RGABinKernel::integrate(const RGAScan& scan, std::vector<double>& averages, unsigned max_threads) const {
+    if (scan.columns() != columns) {
+        throw std::invalid_argument("Error in RGABinKernel::integrate call: scan has "
+        + std::to_string(scan.columns()) + " AMU columns, kernel expects " + std::to_string(columns));
+    }
+
+    const std::size_t rows = scan.rows();
+    averages.assign(rows * binCount(), 0.0);
+    if (rows == 0 || binCount() == 0) {
+        return;
+    }
+
+    // Split the rows into contiguous chunks, one per thread
+    if (max_threads == 0) {
+        max_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const std::size_t thread_count = std::max<std::size_t>(1,
+        std::min<std::size_t>(max_threads, rows / MIN_ROWS_PER_THREAD));
+    if (thread_count == 1) {
+        integrateRows(scan, 0, rows, averages.data());
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    const std::size_t chunk = (rows + thread_count - 1) / thread_count;
+    for (std::size_t t = 1; t < thread_count; ++t) {
+        const std::size_t first = std::min(rows, t * chunk);
+        const std::size_t last = std::min(rows, first + chunk);
+        threads.emplace_back(&RGABinKernel::integrateRows, this, std::cref(scan), first, last, averages.data());
+    }
+    integrateRows(scan, 0, std::min(rows, chunk), averages.data());
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void RGABinKernel::integrateRows(const RGAScan& scan, std::size_t first, std::size_t last, double* averages) const {
+    const std::size_t bins = binCount();
+    const std::uint32_t* offsets = runOffsets.data();
+    const std::uint32_t* begins = runBegin.data();
+    const std::uint32_t* ends = runEnd.data();
+    const double* inverse = inverseCount.data();
+
+    // Prefix sums in double, so the differences keep the precision of a direct sum
+    std::vector<double> prefix(columns + 1, 0.0);
+    for (std::size_t i = first; i < last; ++i) {
+        const float* row = scan.row(i);
+        double running = 0.0;
+        for (std::size_t j = 0; j < columns; ++j) {
+            running += row[j];
+            prefix[j + 1] = running;
+        }
+
+        // Every bin is a handful of flat, branch-free differences of the prefix row
+        double* out = averages + i * bins;
+        for (std::size_t b = 0; b < bins; ++b) {
+            double sum = 0.0;
+            for (std::uint32_t r = offsets[b]; r < offsets[b + 1]; ++r) {
+                sum += prefix[ends[r]] - prefix[begins[r]];
+            }
+            out[b] = sum * inverse[b];
+        }
+    }
+}
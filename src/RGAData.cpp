@@ -1,5 +1,58 @@
 #include "RGAData.hpp"
 
+// Registry of interned bin layouts
+RGAData::BinRegistry& RGAData::BinRegistry::instance() {
+    static BinRegistry registry;
+    return registry;
+}
+
+RGAData::BinId RGAData::BinRegistry::intern(const AMUBins& bins) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return internKey(keyOf(bins.GM, bins.bins), bins);
+}
+
+RGAData::BinId RGAData::BinRegistry::intern(BinId id, const std::string& GM) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const Layout& layout = layouts.at(id);
+    if (layout.bins.GM == GM) {
+        return id;
+    }
+    AMUBins bins = layout.bins;
+    bins.GM = GM;
+    return internKey(LayoutKey(GM, layout.binKey), bins);
+}
+
+const RGAData::AMUBins& RGAData::BinRegistry::bins(BinId id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return layouts.at(id).bins;
+}
+
+const std::string& RGAData::BinRegistry::name(BinId id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return layouts.at(id).name;
+}
+
+RGAData::BinRegistry::LayoutKey RGAData::BinRegistry::keyOf(const std::string& GM, const std::set<double, std::less<>>& bins) {
+    std::vector<long long> bin_key;
+    bin_key.reserve(bins.size());
+    for (double bin : bins) {
+        bin_key.push_back(std::llround(bin / TOLERANCE));
+    }
+    return LayoutKey(GM, std::move(bin_key));
+}
+
+// Caller holds the mutex
+RGAData::BinId RGAData::BinRegistry::internKey(LayoutKey key, const AMUBins& bins) {
+    auto it = ids.find(key);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    BinId id = static_cast<BinId>(layouts.size());
+    layouts.push_back(Layout{bins, bins.binsString(), key.second});
+    ids.emplace(std::move(key), id);
+    return id;
+}
+
 // Constructor with bins per unit
 RGAData::RGAData(const int& bins_per_unit) {
     // Force that bins_per_unit must be less than 5
@@ -8,100 +61,144 @@ RGAData::RGAData(const int& bins_per_unit) {
     }
 
     // Initialize bins around integers 1 to 99
+    BinRegistry& registry = BinRegistry::instance();
     for (int i = 1; i <= 99; ++i) {
         std::vector<double> bin_values;
         for (int j = 0; j < 2 * bins_per_unit + 1; ++j) {
             bin_values.push_back(i - (double) bins_per_unit * 0.1 + (double) j * 0.1);
         }
         AMUBins amubins(bin_values);
-        allTimeSeriesData[amubins] = std::unordered_map<double, double>();
+        BinId id = registry.intern(amubins);
+        binIds.push_back(id);
+        seriesFor(id);
     }
 }
 
 void RGAData::addData(const RGAData::AMUBins& bins, double time, double value) {
-    allTimeSeriesData[bins][time] = value;
+    addData(BinRegistry::instance().intern(bins), time, value);
+}
+
+void RGAData::addData(BinId id, double time, double value) {
+    appendRange(id, &time, &value, 1);
+}
+
+void RGAData::appendRange(BinId id, const double* times, const double* values, std::size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    // Append to the time-series data, replacing any samples at times that already exist
+    Series& series = seriesFor(id);
+    series.samples.append(times, values, count);
 
     // Increment byteSize of object
-    byteSize = byteSize + 16 + bins.bins.size() * 8; // 8 bytes * 2 + 8 bytes * number of bins
+    byteSize = byteSize + static_cast<int>(count) * bytesPerSample[static_cast<std::size_t>(seriesSlot[id])];
+}
+
+void RGAData::append(const RGAData& other) {
+    for (const auto& series : other.allSeries) {
+        appendRange(series.id, series.samples.times.data(), series.samples.values.data(), series.samples.size());
+    }
+}
+
+void RGAData::dropThrough(double time) {
+    for (std::size_t i = 0; i < allSeries.size(); ++i) {
+        const std::size_t dropped = allSeries[i].samples.dropThrough(time);
+        byteSize = byteSize - static_cast<int>(dropped) * bytesPerSample[i];
+    }
 }
 
 int RGAData::getByteSize() const {
     return byteSize;
 }
 
-const std::unordered_map<RGAData::AMUBins, std::unordered_map<double, double, std::hash<double>, std::equal_to<double>, std::allocator<std::pair<const double, double>>>, RGAData::AMUBinsHash, std::equal_to<RGAData::AMUBins>, std::allocator<std::pair<const RGAData::AMUBins, std::unordered_map<double, double, std::hash<double>, std::equal_to<double>, std::allocator<std::pair<const double, double>>>>>>& RGAData::getAllTimeSeriesData() const {
-    return allTimeSeriesData;
+const std::vector<RGAData::Series>& RGAData::getAllSeries() const {
+    return allSeries;
 }
 
-const std::vector<RGAData::AMUBins> RGAData::getBins() {
-    std::vector<RGAData::AMUBins> bins;
-    for(auto element : allTimeSeriesData){
-        bins.push_back(element.first);
+const RGAData::Series* RGAData::findSeries(BinId id) const {
+    if (id >= seriesSlot.size() || seriesSlot[id] < 0) {
+        return nullptr;
     }
-    return bins;
+    return &allSeries[static_cast<std::size_t>(seriesSlot[id])];
+}
+
+std::size_t RGAData::getSampleCount() const {
+    std::size_t count = 0;
+    for (const auto& series : allSeries) {
+        count += series.samples.size();
+    }
+    return count;
+}
+
+const std::vector<RGAData::BinId>& RGAData::getBinIds() const {
+    return binIds;
 }
 
 void RGAData::clearData() {
-    // Clear all the map within each AMUBins
-    for(auto element : allTimeSeriesData){
-        element.second.clear();
+    // Clear all the samples within each series
+    for(auto& series : allSeries){
+        series.samples.clear();
     }
     
     // Reset byteSize
     byteSize = 0;
 }
 
-void RGAData::printAllTimeSeriesData(){
-    for(auto element : allTimeSeriesData){
+void RGAData::printAllTimeSeriesData() const {
+    BinRegistry& registry = BinRegistry::instance();
+    for(const auto& series : allSeries){
         std::string bin_str = "";
-        for(auto bin : element.first.bins){
+        for(auto bin : registry.bins(series.id).bins){
             bin_str += std::to_string(bin) + ",";
         }
         // Remove the last comma
         if(!bin_str.empty()) bin_str.pop_back();
         std::cout << bin_str << "\n";
         
-        for(auto inner_element : element.second){
-            std::cout << "  " << inner_element.first << "," << inner_element.second << "\n";
+        for(std::size_t i = 0; i < series.samples.size(); ++i){
+            std::cout << "  " << series.samples.times[i] << "," << series.samples.values[i] << "\n";
         }
     }
 }
 
-void RGAData::printFileAllTimeSeriesData(const Config& config, const std::string& filename) {
+void RGAData::printFileAllTimeSeriesData(const Config& config, const std::string& filename) const {
+    BinRegistry& registry = BinRegistry::instance();
     std::ofstream outFile(config.getOutputDir() + filename);
-    for(auto element : allTimeSeriesData) {
+    for(const auto& series : allSeries) {
         std::string bin_str = "";
-        for(auto bin : element.first.bins){
+        for(auto bin : registry.bins(series.id).bins){
             bin_str += std::to_string(bin) + ",";
         }
         // Remove the last comma
         if(!bin_str.empty()) bin_str.pop_back();
         outFile << bin_str << "\n";
         
-        for(auto inner_element : element.second) {
-            outFile << inner_element.first << "," << inner_element.second << "\n";
+        for(std::size_t i = 0; i < series.samples.size(); ++i) {
+            outFile << series.samples.times[i] << "," << series.samples.values[i] << "\n";
         }
     }
 }
 
-RGAData RGAData::difference(const RGAData& other) const {
-    const auto& other_data = other.getAllTimeSeriesData();
-    RGAData diff_data;
-    for(const auto& element : allTimeSeriesData){
-        AMUBins amubin = element.first;
-        std::unordered_map<double,double> time_series = element.second;
-        for(auto inner_element : time_series){
-            double time = inner_element.first;
-            double value = inner_element.second;
-            if(other_data.find(amubin) == other_data.end() || other_data.at(amubin).find(time) == other_data.at(amubin).end()){
-                diff_data.addData(amubin, time, value); // Pass AMUBins type directly
-            }
+bool RGAData::is_empty() const {
+    // The series are created up front, so empty means no series holds any data
+    for (const auto& series : allSeries) {
+        if (!series.samples.empty()) {
+            return false;
         }
     }
-
-    return diff_data;
+    return true;
 }
 
-bool RGAData::is_empty() const {
-    return allTimeSeriesData.empty();
+// Internal lookup of the series for id, creating it if needed
+RGAData::Series& RGAData::seriesFor(BinId id) {
+    if (id >= seriesSlot.size()) {
+        seriesSlot.resize(static_cast<std::size_t>(id) + 1, -1);
+    }
+    if (seriesSlot[id] < 0) {
+        seriesSlot[id] = static_cast<std::int32_t>(allSeries.size());
+        allSeries.push_back(Series{id, TimeSeries()});
+        bytesPerSample.push_back(16 + static_cast<int>(BinRegistry::instance().bins(id).bins.size()) * 8);
+    }
+    return allSeries[static_cast<std::size_t>(seriesSlot[id])];
 }
@@ -0,0 +1,116 @@
+#include "RGATailReader.hpp"
+
+#include <sys/stat.h>
+#include <cstring>
+#include <ctime>
+
+std::size_t RGATailReader::poll(
+    const Config& config,
+    RGAData& rga_data,
+    const std::string& GM,
+    int year,
+    int month,
+    int day,
+    bool verbose
+) {
+    LogState& state = logs[LogKey(GM, year, month, day)];
+    if (state.closed) {
+        return 0;
+    }
+
+    // Locate the daily log once, and again if it disappears
+    struct stat file_stat;
+    if (state.fullpath.empty() || ::stat(state.fullpath.c_str(), &file_stat) != 0) {
+        state = LogState();
+        state.fullpath = FileReader::findServerRGADataFile(config, GM, year, month, day, verbose);
+        if (::stat(state.fullpath.c_str(), &file_stat) != 0) {
+            std::string fullpath = state.fullpath;
+            state = LogState();
+            throw std::runtime_error("Error in RGATailReader::poll call: Could not stat file: " + fullpath);
+        }
+        state.device = file_stat.st_dev;
+        state.inode = file_stat.st_ino;
+    }
+
+    // A replaced or truncated log was rewritten, so read it again from the start
+    const std::uintmax_t file_size = static_cast<std::uintmax_t>(file_stat.st_size);
+    if (file_stat.st_dev != state.device || file_stat.st_ino != state.inode || file_size < state.offset) {
+        if (verbose) {
+            std::cout << "In RGATailReader::poll call: file was replaced or truncated, re-reading: " << state.fullpath << "\n";
+        }
+        std::string fullpath = state.fullpath;
+        state = LogState();
+        state.fullpath = fullpath;
+        state.device = file_stat.st_dev;
+        state.inode = file_stat.st_ino;
+    }
+
+    // Read only the bytes appended since the last poll
+    RGAScan scan;
+    if (file_size > state.offset) {
+        std::ifstream file(state.fullpath, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Error in RGATailReader::poll call: Could not open file: " + state.fullpath);
+        }
+        file.seekg(static_cast<std::streamoff>(state.offset));
+        std::string buffer(static_cast<std::size_t>(file_size - state.offset), '\0');
+        file.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+        buffer.resize(static_cast<std::size_t>(file.gcount()));
+
+        // Lines before the header row carry no data
+        const char* begin = buffer.data();
+        const char* end = begin + buffer.size();
+        while (!state.headerFound) {
+            const char* newline = static_cast<const char*>(std::memchr(begin, '\n', static_cast<std::size_t>(end - begin)));
+            if (!newline) {
+                break;
+            }
+            state.headerFound = FileReader::parseRGAHeader(begin, newline, state.layout);
+            begin = newline + 1;
+        }
+
+        // Only complete lines are consumed; a partially written row waits for the next poll
+        if (state.headerFound) {
+            scan.amus = state.layout.amus;
+            begin += FileReader::parseRGARows(begin, end, state.layout, scan, false, true, "RGATailReader::poll");
+        }
+        state.offset += static_cast<std::uintmax_t>(begin - buffer.data());
+    }
+
+    // Add the new rows into the RGAData object
+    if (scan.rows() > 0) {
+        FileReader::addRGAScan(rga_data, GM, scan, verbose);
+    }
+
+    // A past day that has been read to the end and left alone for a while is finished
+    std::time_t now_time = std::time(nullptr);
+    std::tm now_tm = *std::localtime(&now_time);
+    const bool past_day = std::make_tuple(year, month, day) <
+        std::make_tuple(now_tm.tm_year + 1900, now_tm.tm_mon + 1, now_tm.tm_mday);
+    if (past_day && state.offset == file_size &&
+        std::difftime(now_time, file_stat.st_mtime) > CLOSE_AFTER_SECONDS) {
+        state.closed = true;
+        if (verbose) {
+            std::cout << "In RGATailReader::poll call: closed finished daily log: " << state.fullpath << "\n";
+        }
+    }
+
+    if (verbose) {
+        std::cout << "In RGATailReader::poll call: parsed " << scan.rows() << " new rows from: " << state.fullpath << "\n";
+    }
+    return scan.rows();
+}
+
+bool RGATailReader::isClosed(const std::string& GM, int year, int month, int day) const {
+    auto it = logs.find(LogKey(GM, year, month, day));
+    return it != logs.end() && it->second.closed;
+}
+
+std::string RGATailReader::fullpath(const std::string& GM, int year, int month, int day) const {
+    auto it = logs.find(LogKey(GM, year, month, day));
+    return it == logs.end() ? std::string() : it->second.fullpath;
+}
+
+void RGATailReader::clear() {
+    logs.clear();
+}
@@ -0,0 +1,45 @@
+#include "RejectLog.hpp"
+
+RejectLog& RejectLog::instance() {
+    static RejectLog log;
+    return log;
+}
+
+void RejectLog::open(const std::string& reject_path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file.is_open()) {
+        file.close();
+    }
+    path = reject_path;
+    file.open(path, std::ios::app);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error in RejectLog::open call: Could not open file: " + path);
+    }
+}
+
+void RejectLog::quarantine(const std::string& bucket, const std::string& reason, const std::string& rejected) {
+    // One-line reason, so the comment cannot be mistaken for line protocol
+    std::string comment = reason;
+    std::replace(comment.begin(), comment.end(), '\n', ' ');
+    const std::size_t count = static_cast<std::size_t>(std::count(rejected.begin(), rejected.end(), '\n')) +
+        ((!rejected.empty() && rejected.back() != '\n') ? 1 : 0);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    lines += count;
+    if (!file.is_open()) {
+        std::cerr << "Warning in RejectLog::quarantine call: no reject file open, dropping " << count
+        << " lines refused by bucket " << bucket << ": " << comment << "\n";
+        return;
+    }
+    const std::time_t now = std::time(nullptr);
+    file << "# " << now << ' ' << bucket << ' ' << comment << '\n' << rejected;
+    if (!rejected.empty() && rejected.back() != '\n') {
+        file << '\n';
+    }
+    file.flush();
+}
+
+std::size_t RejectLog::count() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lines;
+}
@@ -0,0 +1,57 @@
+#include "RequestBody.hpp"
+
+#include <cstring>
+
+void RequestBody::attach(CURL* handle) {
+    rewind();
+    curl_easy_setopt(handle, CURLOPT_POST, 1L);
+    curl_easy_setopt(handle, CURLOPT_READFUNCTION, ReadCallback);
+    curl_easy_setopt(handle, CURLOPT_READDATA, this);
+    curl_easy_setopt(handle, CURLOPT_SEEKFUNCTION, SeekCallback);
+    curl_easy_setopt(handle, CURLOPT_SEEKDATA, this);
+    // A known size goes out as Content-Length, an unknown one as chunked transfer encoding
+    curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE_LARGE, size());
+}
+
+size_t RequestBody::ReadCallback(char* dest, size_t size, size_t nmemb, void* userp) {
+    return static_cast<RequestBody*>(userp)->read(dest, size * nmemb);
+}
+
+int RequestBody::SeekCallback(void* userp, curl_off_t offset, int origin) {
+    if (origin != SEEK_SET || offset != 0) {
+        return CURL_SEEKFUNC_CANTSEEK;
+    }
+    static_cast<RequestBody*>(userp)->rewind();
+    return CURL_SEEKFUNC_OK;
+}
+
+std::size_t BufferBody::read(char* dest, std::size_t max_length) {
+    std::size_t count = std::min(max_length, length - offset);
+    std::memcpy(dest, data + offset, count);
+    offset += count;
+    return count;
+}
+
+LinesBody::LinesBody(const std::vector<std::string>& lines) : lines(lines) {
+    for (const auto& text : lines) {
+        length += text.size() + 1;
+    }
+}
+
+std::size_t LinesBody::read(char* dest, std::size_t max_length) {
+    std::size_t count = 0;
+    while (count < max_length && line < lines.size()) {
+        const std::string& text = lines[line];
+        if (offset < text.size()) {
+            std::size_t chunk = std::min(max_length - count, text.size() - offset);
+            std::memcpy(dest + count, text.data() + offset, chunk);
+            count += chunk;
+            offset += chunk;
+        } else {
+            dest[count++] = '\n';
+            ++line;
+            offset = 0;
+        }
+    }
+    return count;
+}
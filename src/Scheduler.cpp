@@ -0,0 +1,118 @@
+#include "Scheduler.hpp"
+
+Scheduler& Scheduler::instance() {
+    // Never destroyed: a driver thread may still wait on a job when the process ends
+    static Scheduler* scheduler = new Scheduler();
+    return *scheduler;
+}
+
+void Scheduler::start(int worker_count, double backfill_share) {
+    if (worker_count < 1 || backfill_share <= 0.0 || backfill_share > 1.0) {
+        throw std::invalid_argument("Error in Scheduler::start call: need at least one worker and a backfill share in (0, 1], got " +
+            std::to_string(worker_count) + " and " + std::to_string(backfill_share));
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!workers.empty()) {
+        throw std::runtime_error("Error in Scheduler::start call: already started");
+    }
+    backfillSlots = std::max<std::size_t>(1, static_cast<std::size_t>(worker_count * backfill_share));
+    backfillShare_ = backfill_share;
+    for (int i = 0; i < worker_count; ++i) {
+        workers.emplace_back(&Scheduler::work, this);
+    }
+}
+
+std::future<void> Scheduler::submit(Priority priority, std::function<void()> job) {
+    Job queued{std::packaged_task<void()>(std::move(job)), std::chrono::steady_clock::now()};
+    std::future<void> done = queued.task.get_future();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (workers.empty()) {
+            lock.unlock();
+            queued.task();
+            return done;
+        }
+        const std::size_t index = static_cast<std::size_t>(priority);
+        queues[index].push_back(std::move(queued));
+        stats_[index].queued = queues[index].size();
+    }
+    ready.notify_all();
+    return done;
+}
+
+void Scheduler::run(Priority priority, std::function<void()> job) {
+    submit(priority, std::move(job)).get();
+}
+
+void Scheduler::yieldToRealTime() {
+    std::unique_lock<std::mutex> lock(mutex);
+    ready.wait(lock, [this] { return queues[static_cast<std::size_t>(Priority::RealTime)].empty(); });
+}
+
+SchedulerStats Scheduler::stats(Priority priority) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats_[static_cast<std::size_t>(priority)];
+}
+
+std::string Scheduler::report() const {
+    static const char* names[PRIORITY_CLASSES] = {"real-time", "backfill"};
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ostringstream out;
+    out << "Scheduler:";
+    for (std::size_t i = 0; i < PRIORITY_CLASSES; ++i) {
+        const SchedulerStats& stats = stats_[i];
+        const long long average = stats.completed ? stats.totalWait.count() / static_cast<long long>(stats.completed) : 0;
+        out << " " << names[i] << " queued " << stats.queued << ", running " << stats.running
+            << ", done " << stats.completed << ", wait avg " << average << " ms max " << stats.maxWait.count() << " ms;";
+    }
+    return out.str();
+}
+
+void Scheduler::work() {
+    for (;;) {
+        Job job;
+        Priority priority;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&] { return take(job, priority); });
+        }
+        if (priority == Priority::RealTime) {
+            ready.notify_all(); // Wakes yieldToRealTime() once the real-time queue drained
+        }
+
+        job.task(); // Exceptions end up in the future
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            SchedulerStats& stats = stats_[static_cast<std::size_t>(priority)];
+            --stats.running;
+            ++stats.completed;
+        }
+        // A finished backfill job may free the slot another one waits for
+        ready.notify_all();
+    }
+}
+
+bool Scheduler::take(Job& job, Priority& priority) {
+    std::size_t index;
+    if (!queues[static_cast<std::size_t>(Priority::RealTime)].empty()) {
+        index = static_cast<std::size_t>(Priority::RealTime);
+    } else if (!queues[static_cast<std::size_t>(Priority::Backfill)].empty() &&
+               stats_[static_cast<std::size_t>(Priority::Backfill)].running < backfillSlots) {
+        index = static_cast<std::size_t>(Priority::Backfill);
+    } else {
+        return false;
+    }
+
+    job = std::move(queues[index].front());
+    queues[index].pop_front();
+    priority = static_cast<Priority>(index);
+
+    SchedulerStats& stats = stats_[index];
+    const auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - job.queuedAt);
+    stats.queued = queues[index].size();
+    ++stats.running;
+    stats.totalWait += waited;
+    stats.maxWait = std::max(stats.maxWait, waited);
+    return true;
+}
@@ -0,0 +1,118 @@
+#include "SensorRegistry.hpp"
+#include "MappedFile.hpp"
+
+#include <charconv>
+#include <cstring>
+
+SensorRegistry& SensorRegistry::instance() {
+    static SensorRegistry registry;
+    return registry;
+}
+
+void SensorRegistry::open(const std::string& registry_path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file.is_open()) {
+        file.close();
+    }
+    path = registry_path;
+
+    // Load the entries written by earlier runs; a later line for the same name wins
+    if (std::filesystem::exists(path)) {
+        MappedFile mapped(path);
+        const char* next = mapped.data();
+        const char* end = next + mapped.size();
+        while (next < end) {
+            const char* newline = static_cast<const char*>(std::memchr(next, '\n', static_cast<std::size_t>(end - next)));
+            if (!newline) {
+                break; // A line cut short by a crash is ignored
+            }
+            const char* first_tab = static_cast<const char*>(std::memchr(next, '\t', static_cast<std::size_t>(newline - next)));
+            const char* second_tab = first_tab ? static_cast<const char*>(
+                std::memchr(first_tab + 1, '\t', static_cast<std::size_t>(newline - first_tab - 1))) : nullptr;
+            int id = 0;
+            if (second_tab && std::from_chars(second_tab + 1, newline, id).ec == std::errc() && id > 0) {
+                std::string bucket(next, first_tab);
+                setId(buckets[bucket], bucket, std::string(first_tab + 1, second_tab), id, false);
+            } else {
+                std::cerr << "Warning in SensorRegistry::open call: skipping malformed line in " << path << "\n";
+            }
+            next = newline + 1;
+        }
+    }
+
+    file.open(path, std::ios::app);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error in SensorRegistry::open call: Could not open file: " + path);
+    }
+}
+
+std::vector<int> SensorRegistry::lookup(const std::string& bucket, const std::vector<std::string>& names) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<int> ids(names.size(), -1);
+    auto bucket_it = buckets.find(bucket);
+    if (bucket_it == buckets.end()) {
+        return ids;
+    }
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        auto it = bucket_it->second.ids.find(names[i]);
+        if (it != bucket_it->second.ids.end()) {
+            ids[i] = it->second;
+        }
+    }
+    return ids;
+}
+
+void SensorRegistry::merge(const std::string& bucket, const std::vector<std::pair<std::string, int>>& entries) {
+    std::lock_guard<std::mutex> lock(mutex);
+    BucketIds& bucket_ids = buckets[bucket];
+    for (const auto& entry : entries) {
+        setId(bucket_ids, bucket, entry.first, entry.second, true);
+        bucket_ids.pending.erase(entry.first);
+    }
+    if (file.is_open()) {
+        file.flush();
+    }
+}
+
+std::vector<std::pair<std::string, int>> SensorRegistry::reserve(const std::string& bucket, const std::vector<std::string>& names) {
+    std::lock_guard<std::mutex> lock(mutex);
+    BucketIds& bucket_ids = buckets[bucket];
+    std::vector<std::pair<std::string, int>> reserved;
+    for (const auto& name : names) {
+        auto it = bucket_ids.ids.find(name);
+        if (it != bucket_ids.ids.end()) {
+            reserved.emplace_back(name, it->second);
+            continue;
+        }
+        auto pending = bucket_ids.pending.find(name);
+        if (pending == bucket_ids.pending.end()) {
+            pending = bucket_ids.pending.emplace(name, ++bucket_ids.maxId).first;
+        }
+        reserved.emplace_back(name, pending->second);
+    }
+    return reserved;
+}
+
+void SensorRegistry::confirm(const std::string& bucket, const std::vector<std::pair<std::string, int>>& entries) {
+    merge(bucket, entries);
+}
+
+void SensorRegistry::invalidate(const std::string& bucket) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = buckets.find(bucket);
+    if (it != buckets.end()) {
+        it->second.ids.clear();
+    }
+}
+
+void SensorRegistry::setId(BucketIds& bucket_ids, const std::string& bucket, const std::string& name, int id, bool persist) {
+    auto it = bucket_ids.ids.find(name);
+    if (it != bucket_ids.ids.end() && it->second == id) {
+        return;
+    }
+    bucket_ids.ids[name] = id;
+    bucket_ids.maxId = std::max(bucket_ids.maxId, id);
+    if (persist && file.is_open()) {
+        file << bucket << '\t' << name << '\t' << id << '\n';
+    }
+}
@@ -0,0 +1,212 @@
+#include "SharedSink.hpp"
+
+struct SharedSink::Body {
+    Body(const BatchPolicy& policy, int gzip_level, std::uint64_t body_origin) : batcher(policy), origin(body_origin) {
+        if (gzip_level > 0) {
+            gzip = std::make_unique<GzipCompressor>(gzip_level);
+        }
+    }
+
+    Batcher batcher;
+    std::uint64_t origin;
+    std::unique_ptr<GzipCompressor> gzip;
+    std::string lines;
+    std::size_t lineCount = 0;
+    std::vector<int> sensorIds;
+    int attempts = 1;
+    std::vector<std::shared_ptr<std::promise<void>>> waiting;
+    bool listed = false;
+};
+
+class SharedSink::Destination {
+public:
+    Destination(const std::string& url, const std::string& token, const std::string& bucket,
+                int max_in_flight, int gzip_level, CircuitBreaker* breaker, const BatchPolicy& batch_policy)
+        : policy(batch_policy), gzipLevel(gzip_level),
+          writer(url, token, bucket, max_in_flight, gzip_level, breaker,
+                 [this](std::chrono::milliseconds latency, bool ok) { observe(latency, ok); }) {
+        if (gzip_level > 0) {
+            ratio = GzipCompressor(gzip_level).ratio();
+        }
+    }
+
+    // The open body of origin in a class, created on its first chunk; kept, with its
+    // compressor, for the next chunks of the connection
+    Body& body(Priority priority, std::uint64_t origin) {
+        return bodies[static_cast<std::size_t>(priority)].try_emplace(origin, policy, gzipLevel, origin).first->second;
+    }
+
+    void observe(std::chrono::milliseconds latency, bool ok) {
+        std::lock_guard<std::mutex> lock(watchMutex);
+        for (Batcher* watcher : watchers) {
+            watcher->record(latency, ok);
+        }
+    }
+
+    std::mutex watchMutex;
+    std::vector<Batcher*> watchers;
+    std::atomic<double> ratio{1.0};
+
+    const BatchPolicy policy;
+    const int gzipLevel;
+
+    // Open body of every origin, per class
+    std::unordered_map<std::uint64_t, Body> bodies[PRIORITY_CLASSES];
+
+    // Last, so its thread stops before the members its observer uses
+    AsyncWriter writer;
+};
+
+SharedSink& SharedSink::instance() {
+    // Never destroyed: producers on other threads may push until the process ends
+    static SharedSink* sink = new SharedSink();
+    return *sink;
+}
+
+SharedSink::SharedSink() {
+    for (std::size_t index = 0; index < PRIORITY_CLASSES; ++index) {
+        lanes[index].worker = std::thread(&SharedSink::run, this, static_cast<Priority>(index));
+    }
+}
+
+std::shared_ptr<SharedSink::Destination> SharedSink::destination(const std::string& url, const std::string& token,
+    const std::string& bucket, int max_in_flight, int gzip_level, CircuitBreaker* breaker) {
+    std::lock_guard<std::mutex> lock(destinationsMutex);
+    // Keyed by everything the writer is built from, so a changed setting takes effect
+    std::shared_ptr<Destination>& destination =
+        destinations[url + " " + token + " " + std::to_string(gzip_level) + " " + std::to_string(max_in_flight)];
+    if (!destination) {
+        destination = std::make_shared<Destination>(url, token, bucket, max_in_flight, gzip_level, breaker, policy_);
+    }
+    return destination;
+}
+
+std::future<void> SharedSink::push(const std::shared_ptr<Destination>& destination, std::string lines,
+                                   std::vector<int> sensor_ids, int attempts, Priority priority,
+                                   std::uint64_t origin) {
+    Chunk chunk;
+    chunk.destination = destination;
+    chunk.lines = std::move(lines);
+    chunk.sensorIds = std::move(sensor_ids);
+    chunk.attempts = attempts;
+    chunk.origin = origin;
+    chunk.done = std::make_shared<std::promise<void>>();
+    std::future<void> done = chunk.done->get_future();
+    Lane& lane = lanes[static_cast<std::size_t>(priority)];
+    lane.queue.push(std::move(chunk));
+
+    // Only a sink thread that went idle needs the lock and a notify
+    if (lane.idle.exchange(false)) {
+        std::lock_guard<std::mutex> lock(lane.mutex);
+        lane.wake.notify_one();
+    }
+    return done;
+}
+
+double SharedSink::compressionRatio(const std::shared_ptr<Destination>& destination) const {
+    return destination->ratio.load();
+}
+
+void SharedSink::watch(const std::shared_ptr<Destination>& destination, Batcher* batcher) {
+    std::lock_guard<std::mutex> lock(destination->watchMutex);
+    destination->watchers.push_back(batcher);
+}
+
+void SharedSink::unwatch(const std::shared_ptr<Destination>& destination, Batcher* batcher) {
+    std::lock_guard<std::mutex> lock(destination->watchMutex);
+    auto& watchers = destination->watchers;
+    watchers.erase(std::remove(watchers.begin(), watchers.end(), batcher), watchers.end());
+}
+
+void SharedSink::setPolicy(const BatchPolicy& policy) {
+    std::lock_guard<std::mutex> lock(destinationsMutex);
+    policy_ = policy;
+}
+
+void SharedSink::run(Priority priority) {
+    Lane& lane = lanes[static_cast<std::size_t>(priority)];
+    std::vector<std::pair<Destination*, Body*>> open; // Open bodies of this class
+    for (;;) {
+        Chunk chunk;
+        while (lane.queue.pop(chunk)) {
+            Destination& destination = *chunk.destination;
+            Body& body = destination.body(priority, chunk.origin);
+            if (!body.listed) {
+                body.listed = true;
+                open.emplace_back(&destination, &body);
+            }
+            merge(body, chunk);
+            if (body.batcher.full(body.lineCount, body.lines.size())) {
+                flush(destination, body, priority);
+            }
+        }
+
+        // The queue ran dry: send every body that may not linger any longer
+        std::chrono::milliseconds linger(0);
+        std::vector<std::pair<Destination*, Body*>> still_open;
+        for (const auto& [destination, body] : open) {
+            const auto max_linger = body->batcher.policy().maxLinger;
+            if (!body->lines.empty() && max_linger.count() > 0 &&
+                !body->batcher.full(body->lineCount, body->lines.size())) {
+                still_open.emplace_back(destination, body);
+                linger = linger.count() == 0 ? max_linger : std::min(linger, max_linger);
+                continue;
+            }
+            if (!body->lines.empty()) {
+                flush(*destination, *body, priority);
+            }
+            body->listed = false;
+        }
+        open.swap(still_open);
+
+        // Sleep until a push, or until a lingering body is checked again
+        lane.idle.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!lane.queue.empty()) {
+            lane.idle.store(false);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(lane.mutex);
+        if (open.empty()) {
+            lane.wake.wait(lock, [&lane] { return !lane.idle.load(); });
+        } else {
+            lane.wake.wait_for(lock, std::max(std::chrono::milliseconds(1), linger / 4), [&lane] { return !lane.idle.load(); });
+        }
+        lane.idle.store(false);
+    }
+}
+
+void SharedSink::merge(Body& body, Chunk& chunk) {
+    body.lineCount += static_cast<std::size_t>(std::count(chunk.lines.begin(), chunk.lines.end(), '\n'));
+    if (body.lines.empty()) {
+        body.lines = std::move(chunk.lines);
+    } else {
+        body.lines += chunk.lines;
+    }
+    body.sensorIds.insert(body.sensorIds.end(), chunk.sensorIds.begin(), chunk.sensorIds.end());
+    body.attempts = std::max(body.attempts, chunk.attempts);
+    body.waiting.push_back(std::move(chunk.done));
+}
+
+void SharedSink::flush(Destination& destination, Body& body, Priority priority) {
+    // Compressed here, once per merged body
+    std::string compressed;
+    if (body.gzip) {
+        compressed = body.gzip->compress(body.lines);
+        destination.ratio.store(body.gzip->ratio());
+    }
+    auto waiting = std::make_shared<std::vector<std::shared_ptr<std::promise<void>>>>(std::move(body.waiting));
+    destination.writer.submit(std::move(body.lines), std::move(compressed), std::move(body.sensorIds),
+        body.origin, body.attempts, priority, [waiting](const std::string& error) {
+            for (auto& done : *waiting) {
+                AsyncWriter::settle(*done, error);
+            }
+        });
+
+    body.lines = std::string();
+    body.lineCount = 0;
+    body.sensorIds.clear();
+    body.attempts = 1;
+    body.waiting.clear();
+    body.batcher.flushed();
+}
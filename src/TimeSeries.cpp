@@ -0,0 +1,69 @@
+#include "TimeSeries.hpp"
+
+std::size_t TimeSeries::append(const double* new_times, const double* new_values, std::size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+
+    // Fast path: the new range is ascending and starts after the last stored time
+    bool ordered = times.empty() || new_times[0] > times.back();
+    for (std::size_t i = 1; ordered && i < count; ++i) {
+        ordered = new_times[i] > new_times[i - 1];
+    }
+
+    const std::size_t old_size = times.size();
+    times.insert(times.end(), new_times, new_times + count);
+    values.insert(values.end(), new_values, new_values + count);
+    if (ordered) {
+        return 0;
+    }
+
+    // Slow path: only the new samples and the stored ones from the earliest new time on are
+    // reordered. The new samples are sorted on their own and merged after the stored ones, both
+    // stably, so the last sample of every run of equal times is the latest one.
+    const double earliest = *std::min_element(new_times, new_times + count);
+    const std::size_t start = static_cast<std::size_t>(
+        std::lower_bound(times.begin(), times.begin() + static_cast<std::ptrdiff_t>(old_size), earliest) - times.begin());
+
+    std::vector<std::pair<double, double>> tail;
+    tail.reserve(times.size() - start);
+    for (std::size_t i = start; i < times.size(); ++i) {
+        tail.emplace_back(times[i], values[i]);
+    }
+    const auto by_time = [](const std::pair<double, double>& a, const std::pair<double, double>& b) {
+        return a.first < b.first;
+    };
+    const auto middle = tail.begin() + static_cast<std::ptrdiff_t>(old_size - start);
+    std::stable_sort(middle, tail.end(), by_time);
+    std::inplace_merge(tail.begin(), middle, tail.end(), by_time);
+
+    times.resize(start);
+    values.resize(start);
+    for (std::size_t i = 0; i < tail.size(); ++i) {
+        if (i + 1 < tail.size() && tail[i + 1].first == tail[i].first) {
+            continue; // Superseded by a later sample at the same time
+        }
+        times.push_back(tail[i].first);
+        values.push_back(tail[i].second);
+    }
+    return old_size + count - times.size();
+}
+
+std::size_t TimeSeries::dropThrough(double time) {
+    // Times are ascending, so the samples to remove are a prefix
+    const auto end = std::upper_bound(times.begin(), times.end(), time);
+    const std::size_t count = static_cast<std::size_t>(end - times.begin());
+    times.erase(times.begin(), end);
+    values.erase(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(count));
+    return count;
+}
+
+void TimeSeries::reserve(std::size_t count) {
+    times.reserve(count);
+    values.reserve(count);
+}
+
+void TimeSeries::clear() {
+    times.clear();
+    values.clear();
+}
@@ -0,0 +1,109 @@
+#include "WorkStealingPool.hpp"
+
+WorkStealingPool::WorkStealingPool(int worker_count) {
+    if (worker_count < 1) {
+        throw std::invalid_argument("Error in WorkStealingPool::WorkStealingPool call: need at least one worker, got " +
+            std::to_string(worker_count));
+    }
+    for (int i = 0; i < worker_count; ++i) {
+        queues.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < worker_count; ++i) {
+        workers.emplace_back(&WorkStealingPool::run, this, static_cast<std::size_t>(i));
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return pending == 0; });
+        stopping = true;
+    }
+    work.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task) {
+    Worker& queue = *queues[nextQueue++ % queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++queued;
+        ++pending;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    // Any worker may take it, by stealing if it is not the owner
+    work.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return pending == 0; });
+    if (error) {
+        std::exception_ptr first = error;
+        error = nullptr;
+        std::rethrow_exception(first);
+    }
+}
+
+void WorkStealingPool::run(std::size_t self) {
+    for (;;) {
+        Task task;
+        if (popOwn(self, task) || steal(self, task)) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --queued;
+            }
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) {
+                idle.notify_all();
+            }
+            continue;
+        }
+
+        // Nothing to own or steal: sleep until a submit. A task counted in queued but not
+        // pushed yet only costs another look at the deques.
+        std::unique_lock<std::mutex> lock(mutex);
+        work.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) {
+            return;
+        }
+    }
+}
+
+bool WorkStealingPool::popOwn(std::size_t self, Task& task) {
+    Worker& own = *queues[self];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (own.tasks.empty()) {
+        return false;
+    }
+    task = std::move(own.tasks.front());
+    own.tasks.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::steal(std::size_t self, Task& task) {
+    for (std::size_t i = 1; i < queues.size(); ++i) {
+        Worker& victim = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            ++stolen;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,148 @@
+#include "WriteOutcome.hpp"
+
+#include <cstring>
+
+namespace {
+
+// Undo the JSON escapes of the server message
+std::string unescapeJson(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\\' && i + 1 < text.size()) {
+            char next = text[++i];
+            out.push_back(next == 'n' ? '\n' : next == 't' ? '\t' : next);
+        } else {
+            out.push_back(text[i]);
+        }
+    }
+    return out;
+}
+
+// "line N:" entries of the 2.x parser ("errors encountered on line(s): line 3: ...")
+void findLineNumbers(const std::string& message, std::size_t line_count, std::vector<std::size_t>& lines) {
+    static const char marker[] = "line ";
+    for (std::size_t pos = message.find(marker); pos != std::string::npos; pos = message.find(marker, pos + 1)) {
+        std::size_t digits = pos + sizeof(marker) - 1;
+        std::size_t end = digits;
+        while (end < message.size() && std::isdigit(static_cast<unsigned char>(message[end]))) {
+            ++end;
+        }
+        if (end == digits || end >= message.size() || message[end] != ':') {
+            continue;
+        }
+        std::size_t number = std::stoul(message.substr(digits, end - digits));
+        if (number >= 1 && number <= line_count) {
+            lines.push_back(number - 1);
+        }
+    }
+}
+
+// "unable to parse '<line>': reason" entries of older servers, matched against the body
+void findQuotedLines(const std::string& message, const std::string& body, std::vector<std::size_t>& lines) {
+    static const char marker[] = "unable to parse '";
+    std::vector<std::string> quoted;
+    for (std::size_t pos = message.find(marker); pos != std::string::npos; pos = message.find(marker, pos + 1)) {
+        std::size_t start = pos + sizeof(marker) - 1;
+        std::size_t end = message.find("': ", start);
+        if (end != std::string::npos) {
+            quoted.push_back(message.substr(start, end - start));
+        }
+    }
+    if (quoted.empty()) {
+        return;
+    }
+    std::size_t index = 0;
+    for (std::size_t start = 0; start < body.size(); ++index) {
+        std::size_t end = body.find('\n', start);
+        if (end == std::string::npos) end = body.size();
+        for (const auto& text : quoted) {
+            if (text.size() == end - start && body.compare(start, end - start, text) == 0) {
+                lines.push_back(index);
+                break;
+            }
+        }
+        start = end + 1;
+    }
+}
+
+} // namespace
+
+WriteOutcome WriteOutcome::classify(const std::string& transport_error, long status,
+                                    const std::string& response, const std::string& body) {
+    WriteOutcome outcome;
+    if (!transport_error.empty()) {
+        outcome.kind = Kind::Retry;
+        outcome.message = transport_error;
+        return outcome;
+    }
+
+    outcome.status = status;
+    const bool invalid = response.find("\"code\":\"invalid\"") != std::string::npos;
+    if (status / 100 == 2 && !invalid) {
+        return outcome;
+    }
+    outcome.message = "HTTP " + std::to_string(status) + ": " + response;
+
+    if (status == 413) {
+        outcome.kind = Kind::RejectedBody;
+        return outcome;
+    }
+    if (status != 400 && status != 422 && !invalid) {
+        outcome.kind = Kind::Retry;
+        return outcome;
+    }
+
+    const std::string message = unescapeJson(response);
+    if (message.find("partial write") != std::string::npos) {
+        outcome.kind = Kind::PartialWrite;
+        return outcome;
+    }
+
+    findLineNumbers(message, countLines(body), outcome.badLines);
+    if (outcome.badLines.empty()) {
+        findQuotedLines(message, body, outcome.badLines);
+    }
+    std::sort(outcome.badLines.begin(), outcome.badLines.end());
+    outcome.badLines.erase(std::unique(outcome.badLines.begin(), outcome.badLines.end()), outcome.badLines.end());
+    outcome.kind = outcome.badLines.empty() ? Kind::RejectedBody : Kind::RejectedLines;
+    return outcome;
+}
+
+void WriteOutcome::splitLines(const std::string& body, const std::vector<std::size_t>& bad_lines,
+                              std::string& good, std::string& bad) {
+    good.clear();
+    bad.clear();
+    good.reserve(body.size());
+    std::size_t index = 0;
+    std::size_t next_bad = 0;
+    for (std::size_t start = 0; start < body.size(); ++index) {
+        std::size_t end = body.find('\n', start);
+        end = end == std::string::npos ? body.size() : end + 1;
+        const bool is_bad = next_bad < bad_lines.size() && bad_lines[next_bad] == index;
+        (is_bad ? bad : good).append(body, start, end - start);
+        if (is_bad) {
+            ++next_bad;
+        }
+        start = end;
+    }
+}
+
+bool WriteOutcome::bisect(const std::string& body, std::string& first, std::string& second) {
+    // Cut after the newline closest to the middle
+    std::size_t middle = body.find('\n', body.size() / 2);
+    if (middle == std::string::npos || middle + 1 >= body.size()) {
+        middle = body.rfind('\n', body.size() / 2);
+    }
+    if (middle == std::string::npos || middle + 1 >= body.size()) {
+        return false;
+    }
+    first.assign(body, 0, middle + 1);
+    second.assign(body, middle + 1, std::string::npos);
+    return true;
+}
+
+std::size_t WriteOutcome::countLines(const std::string& body) {
+    std::size_t count = static_cast<std::size_t>(std::count(body.begin(), body.end(), '\n'));
+    return (!body.empty() && body.back() != '\n') ? count + 1 : count;
+}
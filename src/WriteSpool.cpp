@@ -0,0 +1,358 @@
+#include "WriteSpool.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace {
+
+constexpr std::size_t HEADER_BYTES = 2 * sizeof(std::uint32_t);
+
+std::uint32_t checksum(const char* data, std::size_t length) {
+    return static_cast<std::uint32_t>(crc32(0L, reinterpret_cast<const Bytef*>(data), static_cast<uInt>(length)));
+}
+
+// pread until length bytes are read; false at the end of the file
+bool readFully(int fd, char* out, std::size_t length, std::uint64_t offset) {
+    while (length > 0) {
+        ssize_t n = ::pread(fd, out, length, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        out += n;
+        offset += static_cast<std::uint64_t>(n);
+        length -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+std::uint64_t fileSize(int fd) {
+    off_t size = ::lseek(fd, 0, SEEK_END);
+    return size < 0 ? 0 : static_cast<std::uint64_t>(size);
+}
+
+bool writeFully(int fd, const char* data, std::size_t length) {
+    while (length > 0) {
+        ssize_t n = ::write(fd, data, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        length -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+WriteSpool::WriteSpool(const std::string& directory, std::size_t segment_bytes)
+    : directory_(directory), segmentBytes(segment_bytes) {
+    std::filesystem::create_directories(directory_);
+    recover();
+}
+
+WriteSpool::~WriteSpool() {
+    stopDrain();
+    if (readFd >= 0) {
+        ::close(readFd);
+    }
+    if (tailFd >= 0) {
+        ::close(tailFd);
+    }
+}
+
+void WriteSpool::append(const std::string& lines, const std::vector<int>& sensor_ids) {
+    // Build the whole record first, so it goes to disk in one write
+    const std::uint32_t id_count = static_cast<std::uint32_t>(sensor_ids.size());
+    const std::size_t payload_bytes = sizeof(id_count) + sensor_ids.size() * sizeof(std::int32_t) + lines.size();
+    std::string record(HEADER_BYTES + payload_bytes, '\0');
+    char* payload = &record[HEADER_BYTES];
+    std::memcpy(payload, &id_count, sizeof(id_count));
+    for (std::size_t i = 0; i < sensor_ids.size(); ++i) {
+        const std::int32_t id = sensor_ids[i];
+        std::memcpy(payload + sizeof(id_count) + i * sizeof(id), &id, sizeof(id));
+    }
+    std::memcpy(payload + sizeof(id_count) + sensor_ids.size() * sizeof(std::int32_t), lines.data(), lines.size());
+    const std::uint32_t header[2] = {static_cast<std::uint32_t>(payload_bytes), checksum(payload, payload_bytes)};
+    std::memcpy(&record[0], header, HEADER_BYTES);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tail.offset > 0 && tail.offset + record.size() > segmentBytes) {
+        openTail(tail.segment + 1);
+    }
+    if (!writeFully(tailFd, record.data(), record.size()) || ::fdatasync(tailFd) != 0) {
+        const std::string reason = std::strerror(errno);
+        // Drop the torn record, so the next append starts at a record boundary
+        if (::ftruncate(tailFd, static_cast<off_t>(tail.offset)) != 0) {
+            std::cerr << "Warning in WriteSpool::append call: could not cut torn record in " << segmentPath(tail.segment) << "\n";
+        }
+        throw std::runtime_error("Error in WriteSpool::append call: Could not write " + segmentPath(tail.segment) + ": " + reason);
+    }
+    tail.offset += record.size();
+    changed.notify_all();
+}
+
+void WriteSpool::startDrain(Sink drain_sink, std::size_t max_outstanding) {
+    stopDrain();
+    sink = std::move(drain_sink);
+    maxOutstanding = std::max<std::size_t>(1, max_outstanding);
+    stopping = false;
+    worker = std::thread(&WriteSpool::drain, this);
+}
+
+void WriteSpool::stopDrain() {
+    if (!worker.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    worker.join();
+    sink = nullptr;
+}
+
+void WriteSpool::drain() {
+    std::deque<Shipment> shipments;
+
+    // A failed write sends everything after the cursor again; points are idempotent, so
+    // records that were accepted behind the failed one are only written twice
+    auto fail = [&](const std::string& reason) {
+        std::cerr << "Warning in WriteSpool::drain call: " << directory_ << ": " << reason << "\n";
+        for (auto& shipment : shipments) {
+            shipment.done.wait();
+        }
+        shipments.clear();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            readAt = acked;
+            changed.wait_for(lock, RETRY_PAUSE, [this] { return stopping; });
+        }
+        if (readFd >= 0) {
+            ::close(readFd);
+            readFd = -1;
+        }
+    };
+
+    for (;;) {
+        // Acknowledge the writes that finished, in spool order
+        bool failed = false;
+        while (!shipments.empty() &&
+               shipments.front().done.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            try {
+                shipments.front().done.get();
+            } catch (const std::exception& e) {
+                shipments.pop_front();
+                fail(e.what());
+                failed = true;
+                break;
+            }
+            acknowledge(shipments.front().end);
+            shipments.pop_front();
+        }
+
+        Position limit;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping && (failed || shipments.empty())) {
+                return;
+            }
+            limit = tail;
+        }
+        if (failed) {
+            continue;
+        }
+
+        if (!stopping && shipments.size() < maxOutstanding) {
+            Record record;
+            try {
+                if (nextRecord(limit, record)) {
+                    shipments.push_back({sink(std::move(record.lines), std::move(record.sensorIds)), record.end});
+                    continue;
+                }
+            } catch (const std::exception& e) {
+                fail(e.what());
+                continue;
+            }
+        }
+
+        if (!shipments.empty()) {
+            shipments.front().done.wait_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] {
+            return stopping || tail.segment != limit.segment || tail.offset != limit.offset;
+        });
+    }
+}
+
+bool WriteSpool::nextRecord(const Position& limit, Record& record) {
+    for (;;) {
+        if (readAt.segment > limit.segment || (readAt.segment == limit.segment && readAt.offset >= limit.offset)) {
+            return false;
+        }
+        if (readFd < 0) {
+            readFd = ::open(segmentPath(readAt.segment).c_str(), O_RDONLY);
+            if (readFd < 0) {
+                throw std::runtime_error("Error in WriteSpool::nextRecord call: Could not open " + segmentPath(readAt.segment));
+            }
+        }
+
+        // A segment before the tail segment ends after its last record
+        std::uint32_t header[2];
+        bool whole = readFully(readFd, reinterpret_cast<char*>(header), HEADER_BYTES, readAt.offset);
+        std::string payload;
+        if (whole && readAt.offset + HEADER_BYTES + header[0] > fileSize(readFd)) {
+            whole = false;
+        }
+        if (whole) {
+            payload.resize(header[0]);
+            whole = readFully(readFd, &payload[0], payload.size(), readAt.offset + HEADER_BYTES) &&
+                checksum(payload.data(), payload.size()) == header[1];
+            if (!whole || payload.size() < sizeof(std::uint32_t)) {
+                std::cerr << "Warning in WriteSpool::nextRecord call: skipping damaged end of " << segmentPath(readAt.segment) << "\n";
+                whole = false;
+            }
+        }
+        if (!whole) {
+            ::close(readFd);
+            readFd = -1;
+            readAt = readAt.segment < limit.segment ? Position{readAt.segment + 1, 0} : limit;
+            continue;
+        }
+
+        std::uint32_t id_count;
+        std::memcpy(&id_count, payload.data(), sizeof(id_count));
+        const std::size_t lines_at = sizeof(id_count) + static_cast<std::size_t>(id_count) * sizeof(std::int32_t);
+        if (lines_at > payload.size()) {
+            throw std::runtime_error("Error in WriteSpool::nextRecord call: Bad sensor id count in " + segmentPath(readAt.segment));
+        }
+        record.sensorIds.resize(id_count);
+        for (std::size_t i = 0; i < id_count; ++i) {
+            std::int32_t id;
+            std::memcpy(&id, payload.data() + sizeof(id_count) + i * sizeof(id), sizeof(id));
+            record.sensorIds[i] = id;
+        }
+        record.lines.assign(payload, lines_at, std::string::npos);
+        readAt.offset += HEADER_BYTES + payload.size();
+        record.end = readAt;
+        return true;
+    }
+}
+
+void WriteSpool::acknowledge(const Position& position) {
+    Position previous;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        previous = acked;
+        acked = position;
+    }
+
+    // Replace the cursor in one rename; a stale cursor after a crash only resends records
+    const std::string temporary = cursorPath() + ".tmp";
+    {
+        std::ofstream cursor(temporary, std::ios::trunc);
+        cursor << position.segment << ' ' << position.offset << '\n';
+        if (!cursor) {
+            std::cerr << "Warning in WriteSpool::acknowledge call: Could not write " << temporary << "\n";
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, cursorPath(), error);
+
+    for (std::uint64_t segment = previous.segment; segment < position.segment; ++segment) {
+        std::filesystem::remove(segmentPath(segment), error);
+    }
+}
+
+void WriteSpool::recover() {
+    // Acknowledged position of the last run
+    std::ifstream cursor(cursorPath());
+    if (!(cursor >> acked.segment >> acked.offset)) {
+        acked = Position();
+    }
+
+    // Segments behind the cursor are finished; a crash may have kept them
+    std::vector<std::uint64_t> segments;
+    for (const auto& entry : std::filesystem::directory_iterator(directory_)) {
+        if (entry.path().extension() == ".spool") {
+            segments.push_back(std::stoull(entry.path().stem().string()));
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+    std::error_code error;
+    while (!segments.empty() && segments.front() < acked.segment) {
+        std::filesystem::remove(segmentPath(segments.front()), error);
+        segments.erase(segments.begin());
+    }
+    if (segments.empty() || segments.front() != acked.segment) {
+        acked = Position{segments.empty() ? acked.segment : segments.front(), 0};
+    }
+    readAt = acked;
+
+    // Keep the whole records of the last segment
+    tail = Position{segments.empty() ? acked.segment : segments.back(), 0};
+    int fd = ::open(segmentPath(tail.segment).c_str(), O_RDONLY);
+    if (fd >= 0) {
+        const std::uint64_t size = fileSize(fd);
+        std::uint32_t header[2];
+        std::string payload;
+        while (readFully(fd, reinterpret_cast<char*>(header), HEADER_BYTES, tail.offset)) {
+            if (tail.offset + HEADER_BYTES + header[0] > size) {
+                break;
+            }
+            payload.resize(header[0]);
+            if (!readFully(fd, &payload[0], payload.size(), tail.offset + HEADER_BYTES) ||
+                checksum(payload.data(), payload.size()) != header[1]) {
+                break;
+            }
+            tail.offset += HEADER_BYTES + payload.size();
+        }
+        ::close(fd);
+    }
+    openTail(tail.segment);
+    if (::ftruncate(tailFd, static_cast<off_t>(tail.offset)) != 0) {
+        throw std::runtime_error("Error in WriteSpool::recover call: Could not cut " + segmentPath(tail.segment));
+    }
+    if (tail.segment == acked.segment && acked.offset > tail.offset) {
+        acked.offset = tail.offset;
+        readAt = acked;
+    }
+    if (!segments.empty() && (tail.offset > acked.offset || tail.segment > acked.segment)) {
+        std::cout << "WriteSpool: resuming " << directory_ << " at segment " << acked.segment
+        << " offset " << acked.offset << "\n";
+    }
+}
+
+void WriteSpool::openTail(std::uint64_t segment) {
+    if (tailFd >= 0) {
+        ::close(tailFd);
+    }
+    tailFd = ::open(segmentPath(segment).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (tailFd < 0) {
+        throw std::runtime_error("Error in WriteSpool::openTail call: Could not open " + segmentPath(segment) +
+            ": " + std::strerror(errno));
+    }
+    tail = Position{segment, tail.segment == segment ? tail.offset : 0};
+}
+
+std::string WriteSpool::segmentPath(std::uint64_t segment) const {
+    std::ostringstream name;
+    name << std::setw(12) << std::setfill('0') << segment << ".spool";
+    return (std::filesystem::path(directory_) / name.str()).string();
+}
+
+std::string WriteSpool::cursorPath() const {
+    return (std::filesystem::path(directory_) / "cursor").string();
+}
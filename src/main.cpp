@@ -39,6 +39,19 @@
 #include "InfluxDatabase.hpp"
 #include "influxdb.hpp"
 #include "RGAData.hpp"
+#include "RGATailReader.hpp"
+#include "DeltaTracker.hpp"
+#include "SensorRegistry.hpp"
+#include "RejectLog.hpp"
+#include "Batcher.hpp"
+#include "SharedSink.hpp"
+#include "Scheduler.hpp"
+#include "WorkStealingPool.hpp"
+#include "BoundedQueue.hpp"
+#include "FileIndex.hpp"
+#include "IngestLedger.hpp"
+#include "CopyPipeline.hpp"
+#include "FileLoader.hpp"
 #include <curl/curl.h>
 #include <future>
 
@@ -73,129 +86,244 @@ std::string time_now() {
     return time_str + "|| ";
 }
 
-int copyEpitrendDataToInflux(InfluxDatabase influx_db, 
-EpitrendBinaryData& binary_data, 
-std::string GM, 
-int year, 
-int month, 
-int day, 
-int hour) {
-    try {
-        // Parse the Epitrend binary data file
-        FileReader::parseServerEpitrendBinaryDataFile(config, binary_data, GM, year,month,day,hour,false);
-        std::cout << time_now() << "Parsed " + GM + " Epitrend data file for: " << year << "," << month << "," << day << "," << hour << "\n";
+// Batch policy preset, overridden by the optional <prefix>_LINES, _BYTES, _LINGER_MS and _ADAPTIVE keys
+BatchPolicy batchPolicyFromConfig(const std::string& prefix, BatchPolicy policy) {
+    policy.maxLines = std::stoul(config.getValueOr(prefix + "_LINES", std::to_string(policy.maxLines)));
+    policy.maxBytes = std::stoul(config.getValueOr(prefix + "_BYTES", std::to_string(policy.maxBytes)));
+    policy.maxLinger = std::chrono::milliseconds(std::stol(config.getValueOr(prefix + "_LINGER_MS", std::to_string(policy.maxLinger.count()))));
+    policy.adaptive = config.getValueOr(prefix + "_ADAPTIVE", policy.adaptive ? "1" : "0") == "1";
+    return policy;
+}
 
-    } catch ( std::exception& e) {
-        // Catching errors due to times that exist
-        std::cout << time_now() << "No " + GM + " Epitrend data file found for: " << year << "," << month << "," << day << "," << hour << "\n" << e.what() << "\n";
-        return 0;
+// Parsed files are handed to influx once about this many bytes of samples have accumulated
+BatchPolicy backfillFlushPolicy() {
+    BatchPolicy policy;
+    policy.maxLines = 0;
+    policy.maxBytes = 100000;
+    return batchPolicyFromConfig("BACKFILL_FLUSH", policy);
+}
+
+// Shared backoff of the influx server, overridden by the optional INFLUX_BREAKER_FAILURES,
+// _BASE_MS and _MAX_MS keys
+BreakerPolicy breakerPolicyFromConfig() {
+    BreakerPolicy policy;
+    policy.failureThreshold = std::stoi(config.getValueOr("INFLUX_BREAKER_FAILURES", std::to_string(policy.failureThreshold)));
+    policy.baseDelay = std::chrono::milliseconds(std::stol(config.getValueOr("INFLUX_BREAKER_BASE_MS", std::to_string(policy.baseDelay.count()))));
+    policy.maxDelay = std::chrono::milliseconds(std::stol(config.getValueOr("INFLUX_BREAKER_MAX_MS", std::to_string(policy.maxDelay.count()))));
+    return policy;
+}
+
+// Apply the optional write settings of the config file to an influx connection; each
+// connection spools to its own directory, so real-time batches never queue behind backfill
+void configureInfluxWrites(InfluxDatabase& influx_db, const BatchPolicy& batch_policy, const std::string& spool_name,
+                           Priority priority) {
+    influx_db.setWritePriority(priority);
+    influx_db.setGzipCompression(config.getInfluxGzipLevel());
+    influx_db.setMaxInFlightWrites(config.getInfluxMaxInFlight());
+    influx_db.setBatchPolicy(batch_policy);
+    influx_db.breaker().setPolicy(breakerPolicyFromConfig());
+    if (config.getInfluxSpool()) {
+        influx_db.enableSpool(config.getSpoolDir() + spool_name);
     }
+}
 
-    // Check the current size of the epitrend binary data object
-    std::cout << time_now() << "Current size of " + GM + " EpitrendBinaryData object: " << binary_data.getByteSize() << "\n";
-    if (binary_data.getByteSize() > 0.1 * pow(10.0, 6.0) ) { // Limit INSERTS to ~10 mb packs
-        std::cout << time_now() << "Curret " + GM + " epitrend data object exceeded size limit -> inserting data into SQL DB and flushing object...\n";
-
-        // ===================INFLUXDB VERSION===================
-        // CHECK IF PART NAME IS IN NS TABLE
-        // IF IT ISN'T
-            // ADD ENTRY OF MACHINE NAME AND PART NAME INTO TABLE
-            // GET NEW SENSOR_ID FOR NAME AND ALSO INTO TABLE
-        // IF IT IS
-            // GET THE SENSOR_ID
-        // ENTER DATA INTO TS TABLE WITH ASSOCIATE SENSOR ID
-
-        // Copy all data into influxDB table
-        int num_tries_counter = 0;
-        for (int i = 0; i < 100; ++i) {
-            try {
-                influx_db.copyEpitrendToBucket2(binary_data, false);
-                break; 
-            } catch (std::exception& e) {
-                std::cout << time_now() << "Error in copying " + GM + " data to influxDB: " << e.what() << "\n Retrying...\n";
-                num_tries_counter++;
-                if (num_tries_counter == 100) {
-                    std::cout << time_now() << "Failed to copy " + GM + " data to influxDB after 3 tries\n";
-                    return -1;
-                }
+// A source file whose samples are in flight, recorded in the ledger once they are sent
+struct PendingFile {
+    std::string path;
+    LedgerEntry observed;
+    std::map<std::string, double> sentMarks; // Of a polled file, see PolledFile
+};
+
+// Ledger state of the files a real-time loop polls: what an earlier run already sent (the
+// floor) and what this run sent since, with the last sample sent of every series. A poll
+// only holds the series that changed, so the watermark recorded is the earliest of these
+// marks: a restart then never drops a sample of a series behind the others.
+struct PolledFile {
+    double floor = -std::numeric_limits<double>::infinity();
+    LedgerEntry observed;
+    std::map<std::string, double> sentMarks;
+};
+
+// Key of a series in the sent marks of a polled file
+std::string seriesKey(const EpitrendBinaryData::Series& series) { return series.name; }
+std::string seriesKey(const RGAData::Series& series) { return std::to_string(series.id); }
+
+// Drop the samples of a polled file that an earlier run already sent, looking the file up in
+// the ledger the first time it is seen; a file with new samples goes to pending, or updates
+// its entry there when an earlier poll could not send it
+template <typename Data>
+void resumeFromLedger(const std::string& path, Data& polled, std::map<std::string, PolledFile>& polled_files,
+                      std::vector<PendingFile>& pending) {
+    if (path.empty()) {
+        return;
+    }
+    auto it = polled_files.find(path);
+    if (it == polled_files.end()) {
+        PolledFile file;
+        IngestLedger::instance().plan(path, file.observed);
+        file.floor = file.observed.watermark;
+        it = polled_files.emplace(path, file).first;
+    }
+    const PolledFile& known = it->second;
+    polled.dropThrough(known.floor);
+    if (polled.is_empty()) {
+        return;
+    }
 
-                // Pause for 10 seconds
-                std::this_thread::sleep_for(std::chrono::seconds(10));
+    auto pending_it = std::find_if(pending.begin(), pending.end(),
+        [&path](const PendingFile& file) { return file.path == path; });
+    if (pending_it == pending.end()) {
+        pending_it = pending.insert(pending.end(), PendingFile{path, known.observed, known.sentMarks});
+    }
+    PendingFile& file = *pending_it;
+    for (const auto& series : polled.getAllSeries()) {
+        if (!series.samples.empty()) {
+            double& mark = file.sentMarks.try_emplace(seriesKey(series), known.floor).first->second;
+            mark = std::max(mark, series.samples.times.back());
+        }
+    }
+    double watermark = std::numeric_limits<double>::infinity();
+    for (const auto& [key, mark] : file.sentMarks) {
+        watermark = std::min(watermark, mark);
+    }
+    file.observed.watermark = std::max(known.floor, watermark);
+
+    // The fingerprint reads the file, so it is only taken again once the file changed
+    std::error_code error;
+    const std::uintmax_t size = std::filesystem::file_size(path, error);
+    const auto mtime = error ? std::filesystem::file_time_type() : std::filesystem::last_write_time(path, error);
+    if (!error) {
+        const std::int64_t modified = static_cast<std::int64_t>(mtime.time_since_epoch().count());
+        if (size != file.observed.size || modified != file.observed.mtime) {
+            file.observed.mtime = modified;
+            file.observed.size = size;
+            file.observed.hash = IngestLedger::fingerprint(path, size);
+        }
+    }
+    file.observed.points += polled.getSampleCount();
+}
 
-            }
+// Record the pending files once their samples were acknowledged
+void recordPendingFiles(std::vector<PendingFile>& pending, std::map<std::string, PolledFile>* polled_files = nullptr) {
+    for (const PendingFile& file : pending) {
+        IngestLedger::instance().record(file.path, file.observed);
+        if (polled_files) {
+            PolledFile& polled = (*polled_files)[file.path];
+            polled.observed = file.observed;
+            polled.sentMarks = file.sentMarks;
         }
-        
-        
-        // Count the number of entries in the database
-        int db_entry_count = 0;
-        for(auto element : binary_data.getAllTimeSeriesData()){
-            db_entry_count += element.second.size();
+    }
+    pending.clear();
+}
+
+// Send the new samples of a real-time poll, trying up to max_tries times; false once they all
+// failed. Only the encoding runs as a real-time job on the scheduler: the wait for the server
+// and the pauses between tries stay on the calling thread, so an outage neither ties up the
+// workers nor holds back backfill. A retry sends only the batches the server did not accept.
+template <typename Data>
+bool sendRealTime(InfluxDatabase& influx_db, const Data& data, int max_tries, int sleep_seconds,
+                  const std::string& caller, const std::string& source) {
+    std::vector<InfluxDatabase::EncodedBatch> batches;
+    bool encoded = false;
+    for (int i = 1; i <= max_tries; ++i) {
+        // Returns at once while the server is healthy, else when the shared backoff allows a try
+        influx_db.breaker().wait();
+        try {
+            Scheduler::instance().run(Priority::RealTime, [&] {
+                if (!encoded) {
+                    batches = influx_db.encodeBatches(data);
+                    encoded = true;
+                }
+                for (auto& batch : batches) {
+                    influx_db.encodeAgain(data, batch);
+                }
+            });
+            influx_db.sendBatches(batches);
+            return true;
+
+        } catch (std::exception& e) {
+            std::cout << time_now() << caller << "Error in copying " << source << " data to influxDB: " << e.what() << "\n Retrying...\n";
+            if (i < max_tries) {
+                // The writer already counted transport and server errors with the shared breaker,
+                // which spaces out the next try; anything else waits the usual pause
+                std::this_thread::sleep_for(std::chrono::seconds(sleep_seconds));
+            }
         }
-        std::cout << "Number of " + GM + " entries in the database: " << db_entry_count << "\n";
-        std::cout << "Approximate db size increased: " << db_entry_count * 100 << 
-        " bytes" << " = " << db_entry_count * 100 / pow(10.0, 6.0) << " MB" << "\n";
-        
-        // Flush the current epitrend data object
-        binary_data.clear();
     }
-    return 1;
+    return false;
 }
 
-int copyRGADataToInflux(InfluxDatabase influx_db,
-RGAData& rga_data,
-std::string GM,
-int year,
-int month,
-int day) {
+// One hour of Epitrend data of one GM, parsed by a backfill worker
+struct EpitrendFile {
+    std::string GM;
+    int year, month, day, hour;
+    EpitrendBinaryData data;
+    PendingFile ingested;
+};
+
+// Parse one hour file from the bytes the loader read ahead; false when there is none for that hour
+bool parseEpitrendFile(EpitrendFile& file, FileLoader& loader) {
+    const std::string format_path = FileReader::serverEpitrendBinaryFormatPath(config, file.GM, file.year, file.month, file.day, file.hour);
+    const std::string data_path = FileReader::serverEpitrendBinaryDataPath(config, file.GM, file.year, file.month, file.day, file.hour);
+    try {
+        // Parse the Epitrend binary data file
+        const std::string format_bytes = loader.take(format_path);
+        const std::string data_bytes = loader.take(data_path);
+        FileReader::parseLoadedEpitrendBinaryDataFile(format_bytes, data_bytes, data_path, file.data, false);
+        std::cout << time_now() << "Parsed " + file.GM + " Epitrend data file for: " << file.year << "," << file.month << "," << file.day << "," << file.hour << "\n";
+        return true;
 
+    } catch ( std::exception& e) {
+        // Catching errors due to times that exist
+        loader.discard(data_path);
+        std::cout << time_now() << "No " + file.GM + " Epitrend data file found for: " << file.year << "," << file.month << "," << file.day << "," << file.hour << "\n" << e.what() << "\n";
+        return false;
+    }
+}
+
+// Parse an indexed RGA daily log; false when it cannot be read
+bool parseRGAFile(const IndexedFile& file, RGAData& rga_data) {
 try {
     // Parse the RGA data file
-    FileReader::parseServerRGADataFile(config, rga_data, GM, year, month, day, false);
-    std::cout << time_now() << "Parsed " + GM + " RGA data file for: " << year << "," << month << "," << day << "\n";
+    FileReader::parseServerRGADataFile(file.path, rga_data, file.GM, false);
+    std::cout << time_now() << "Parsed " + file.GM + " RGA data file for: " << file.year << "," << file.month << "," << file.day << "\n";
+    return true;
 
 } catch (const std::exception& e) {
     std::cerr << e.what() << "\n";
-    std::cout << time_now() << "No " + GM + " RGA data file found for: " << year << "," << month << "," << day << "\n" << e.what() << "\n";
-
+    std::cout << time_now() << "Could not parse " + file.GM + " RGA data file for: " << file.year << "," << file.month << "," << file.day << "\n" << e.what() << "\n";
+    return false;
+}
 }
 
-// Check the current size of the RGA binary data object
-std::cout << time_now() << "Currently copying " + GM + " RGA data object into DB for " << year << "," << month << "," << day << "\n";
-std::cout << time_now() << "Current size of " + GM + " RGAData object: " << rga_data.getByteSize() << "\n";
-if (rga_data.getByteSize() > 0.1 * pow(10.0, 6.0) ) { // Limit INSERTS to ~10 mb packs
-    std::cout << time_now() << "Curret " + GM + " RGA data object exceeded size limit -> inserting data into SQL DB and flushing object...\n";
-
-    int num_tries_counter = 0;
-    for (int i = 0; i < 100; ++i) {
-        try {
-            influx_db.copyRGADataToBucket(rga_data, false);
-            break;
-        } catch (const std::exception& e) {
-            std::cout << time_now() << "Error in copying " + GM + " RGA data to influxDB: " << e.what() << "\n Retrying...\n";
-            std::cerr << e.what() << "\n";
-            if (num_tries_counter == 100) {
-                std::cout << time_now() << "Failed to copy " + GM + " RGA data to influxDB after 100 tries\n";
-                return -1;
-
-            }
-
-        }
+// Hand the accumulated files of a GM to the copy pipeline once the accumulator is full, or
+// whatever is left when final is set; the files go to the ledger once their block was sent
+template <typename Data>
+void copyToPipeline(CopyPipeline<Data>& pipeline,
+Data& data,
+Batcher& accumulator,
+std::vector<PendingFile>& pending,
+const std::string& GM,
+bool final) {
+    // Files without new samples have nothing in flight
+    if (data.is_empty()) {
+        recordPendingFiles(pending);
+        return;
     }
 
-    // Count the number of entries in the database
-    int db_entry_count = 0;
-    for(auto element : rga_data.getAllTimeSeriesData()){
-        db_entry_count += element.second.size();
+    // Check the current size of the accumulated data object
+    std::cout << time_now() << "Current size of " + GM + " data object: " << data.getByteSize() << "\n";
+    if (accumulator.full(data.getSampleCount(), data.getByteSize()) || final) {
+        std::cout << time_now() << "Current " + GM + " data object exceeded size limit -> handing it to the influxDB pipeline and flushing object...\n";
+        std::cout << "Number of " + GM + " entries queued for the database: " << data.getSampleCount() << "\n";
+
+        // Waits while the encoders are behind; the object starts over empty
+        pipeline.submit(std::exchange(data, Data()), [files = std::move(pending)]() mutable {
+            recordPendingFiles(files);
+        });
+        pending.clear();
+        accumulator.flushed();
     }
-    std::cout << "Number of " + GM + " RGA entries in the database: " << db_entry_count << "\n";
-    std::cout << "Approximate db size increased: " << db_entry_count * 100 << 
-    " bytes" << " = " << db_entry_count * 100 / pow(10.0, 6.0) << " MB" << "\n";
-    
-    // Flush the current RGA data object
-    rga_data.clearData();
-}    
-
-return 1;
 }
 
 void processRealTimeRGAData(std::promise<void> exitSignal) {
@@ -210,16 +338,27 @@ void processRealTimeRGAData(std::promise<void> exitSignal) {
 
         // Check the health of the connection
         influx_db.checkConnection(true);
+        configureInfluxWrites(influx_db, batchPolicyFromConfig("INFLUX_REALTIME_BATCH", BatchPolicy::realTime()), "rga_realtime", Priority::RealTime);
 
-        // Update the database real-time - every second
-        RGAData previous_RGA_data_GM1(integration_count), previous_RGA_data_GM2(integration_count),
-        previous_RGA_data_Cluster(integration_count),
-        current_RGA_data_GM1(integration_count), current_RGA_data_GM2(integration_count),
-        current_RGA_data_Cluster(integration_count),
-        difference_RGA_data_GM1, difference_RGA_data_GM2,
-        difference_RGA_data_Cluster;
+        // Update the database real-time - every sleep_seconds
+        // The tail reader only parses rows appended to each daily log since the last poll,
+        // and the delta tracker drops rows already sent if a replaced log is read again
+        RGAData current_RGA_data_GM1(integration_count), current_RGA_data_GM2(integration_count),
+        current_RGA_data_Cluster(integration_count);
+        RGATailReader rga_tail_reader;
+        DeltaTracker rga_delta_tracker;
+
+        // Daily logs in the ledger: a restart resumes after what the last run sent. Rows that could
+        // not be sent stay in the data objects, with their files pending, for the next poll.
+        std::map<std::string, PolledFile> polled_files;
+        std::vector<PendingFile> pending_GM1, pending_GM2, pending_Cluster;
 
         while (true) {
+        // Reading the logs runs as a real-time job on the scheduler, ahead of any backfill; the
+        // sends below wait for the server on this thread
+        RGAData new_RGA_data_GM1, new_RGA_data_GM2, new_RGA_data_Cluster;
+        bool parse_failed = false;
+        Scheduler::instance().run(Priority::RealTime, [&] {
         std::cout << time_now() << "processRealTimeRGAData||" << "Updating database in real-time...\n";
 
         // Grab the current year, month, day, and hour
@@ -229,7 +368,6 @@ void processRealTimeRGAData(std::promise<void> exitSignal) {
         int year = now_tm->tm_year + 1900;
         int month = now_tm->tm_mon + 1;
         int day = now_tm->tm_mday - 1;
-        int hour = now_tm->tm_hour;
 
         std::cout << time_now() << "processRealTimeRGAData||" << "Processing RGA data for: " << year << "," << month << "," << day << "\n";
 
@@ -249,129 +387,94 @@ void processRealTimeRGAData(std::promise<void> exitSignal) {
 
             // Parse GM1 RGA Data
             try {
-                FileReader::parseServerRGADataFile(config, current_RGA_data_GM1, "GM1", loop_year, loop_month, loop_day, false);
+                RGAData polled_RGA_data(integration_count);
+                rga_tail_reader.poll(config, polled_RGA_data, "GM1", loop_year, loop_month, loop_day, false);
+                resumeFromLedger(rga_tail_reader.fullpath("GM1", loop_year, loop_month, loop_day), polled_RGA_data, polled_files, pending_GM1);
+                current_RGA_data_GM1.append(polled_RGA_data);
                 std::cout << time_now() << "processRealTimeRGAData||" << "Parsed GM1 RGA data file for: " << loop_year << "," << loop_month << "," << loop_day << "\n";
             } catch (std::exception& e) {
                 std::cout << time_now() << "processRealTimeRGAData||" << "Warning during parsing GM1 RGA data file for " << loop_year << "," << loop_month << "," << loop_day << ": " << e.what() << "\n";
-                std::this_thread::sleep_for(std::chrono::seconds(parse_error_sleep_seconds));
+                parse_failed = true;
             }
 
             // Parse GM2 RGA Data
             try {
-                FileReader::parseServerRGADataFile(config, current_RGA_data_GM2, "GM2", loop_year, loop_month, loop_day, false);
+                RGAData polled_RGA_data(integration_count);
+                rga_tail_reader.poll(config, polled_RGA_data, "GM2", loop_year, loop_month, loop_day, false);
+                resumeFromLedger(rga_tail_reader.fullpath("GM2", loop_year, loop_month, loop_day), polled_RGA_data, polled_files, pending_GM2);
+                current_RGA_data_GM2.append(polled_RGA_data);
                 std::cout << time_now() << "processRealTimeRGAData||" << "Parsed GM2 RGA data file for: " << loop_year << "," << loop_month << "," << loop_day << "\n";
             } catch (std::exception& e) {
                 std::cout << time_now() << "processRealTimeRGAData||" << "Warning during parsing GM2 RGA data file for " << loop_year << "," << loop_month << "," << loop_day << ": " << e.what() << "\n";
-                std::this_thread::sleep_for(std::chrono::seconds(parse_error_sleep_seconds));
+                parse_failed = true;
             }
 
             // Parse Cluster RGA Data
             try {
-                FileReader::parseServerRGADataFile(config, current_RGA_data_Cluster, "Cluster", loop_year, loop_month, loop_day, false);
+                RGAData polled_RGA_data(integration_count);
+                rga_tail_reader.poll(config, polled_RGA_data, "Cluster", loop_year, loop_month, loop_day, false);
+                resumeFromLedger(rga_tail_reader.fullpath("Cluster", loop_year, loop_month, loop_day), polled_RGA_data, polled_files, pending_Cluster);
+                current_RGA_data_Cluster.append(polled_RGA_data);
                 std::cout << time_now() << "processRealTimeRGAData||" << "Parsed Cluster RGA data file for: " << loop_year << "," << loop_month << "," << loop_day << "\n";
             } catch (std::exception& e) {
                 std::cout << time_now() << "processRealTimeRGAData||" << "Warning during parsing Cluster RGA data file for " << loop_year << "," << loop_month << "," << loop_day << ": " << e.what() << "\n";
-                std::this_thread::sleep_for(std::chrono::seconds(parse_error_sleep_seconds));
+                parse_failed = true;
             }
         }
 
-        // Find the difference between the previous and current data
-        difference_RGA_data_GM1 = current_RGA_data_GM1.difference(previous_RGA_data_GM1);
-        difference_RGA_data_GM2 = current_RGA_data_GM2.difference(previous_RGA_data_GM2);
-        difference_RGA_data_Cluster = current_RGA_data_Cluster.difference(previous_RGA_data_Cluster);
-
-        // Copy the difference data to the influxDB
-        if(!difference_RGA_data_GM1.is_empty()) {
-            // Try to copy the data to influxDB with max_reconnect_attempts retries
-            for(int i = 0; i < max_reconnect_attempts; ++i) {
-                try {    
-                    std::cout << time_now() << "processRealTimeRGAData||" << "Found difference data for GM1... copying the following data into influxDB: \n";            
-                    influx_db.copyRGADataToBucket(difference_RGA_data_GM1, false);
-                    
-                    break;  
-                
-                } catch (std::exception& e) {
-                    std::cout << time_now() << "processRealTimeRGAData||" << "Error in copying GM1 RGA data to influxDB: " << e.what() << "\n Retrying...\n";
-                    if (i == max_reconnect_attempts) {
-                        std::cout << time_now() << "processRealTimeRGAData||" << "Failed to copy GM1 RGA data to influxDB after " << max_reconnect_attempts << " tries\n";
-                        exit(-1);
-                    }
-                                
-                    // Pause
-                    std::this_thread::sleep_for(std::chrono::seconds(sleep_seconds));
 
-                }
-            }
-        }
-        else {
-            std::cout << time_now() << "processRealTimeRGAData||" << "No difference data found for GM1\n";
+        // Keep only the samples that were not sent yet
+        rga_delta_tracker.delta(current_RGA_data_GM1, new_RGA_data_GM1);
+        rga_delta_tracker.delta(current_RGA_data_GM2, new_RGA_data_GM2);
+        rga_delta_tracker.delta(current_RGA_data_Cluster, new_RGA_data_Cluster);
+
+        });
+        if (parse_failed) {
+            std::this_thread::sleep_for(std::chrono::seconds(parse_error_sleep_seconds));
         }
-        if(!difference_RGA_data_GM2.is_empty()) {
-                // Try to copy the data to influxDB with 100 retries
-            for(int i = 0; i < max_reconnect_attempts; ++i) {
-                try {    
-                    std::cout << time_now() << "processRealTimeRGAData||" << "Found difference data for GM2... copying the following data into influxDB: \n";
-                    influx_db.copyRGADataToBucket(difference_RGA_data_GM2, false);
-                    
-                    break;
-                    
-                } catch (std::exception& e) {
-                    std::cout << time_now() << "processRealTimeRGAData||" << "Error in copying GM2 data to influxDB: " << e.what() << "\n Retrying...\n";
-                    if (i == max_reconnect_attempts) {
-                        std::cout << time_now() << "processRealTimeRGAData||" << "Failed to copy GM2 data to influxDB after " << max_reconnect_attempts << " tries\n";
-                        exit(-1);
-                    }
-                                
-                    // Pause
-                    std::this_thread::sleep_for(std::chrono::seconds(sleep_seconds));
 
-                }
+        // Copy the new data to the influxDB
+        if(!new_RGA_data_GM1.is_empty()) {
+            std::cout << time_now() << "processRealTimeRGAData||" << "Found new data for GM1... copying the following data into influxDB: \n";
+            if (sendRealTime(influx_db, new_RGA_data_GM1, max_reconnect_attempts, sleep_seconds, "processRealTimeRGAData||", "GM1 RGA")) {
+                rga_delta_tracker.commit(new_RGA_data_GM1);
+                recordPendingFiles(pending_GM1, &polled_files);
+                current_RGA_data_GM1.clearData();
+            } else {
+                std::cout << time_now() << "processRealTimeRGAData||" << "Failed to copy GM1 RGA data to influxDB after " << max_reconnect_attempts << " tries, keeping it for the next poll\n";
             }
         } else {
-            std::cout << time_now() << "processRealTimeRGAData||" << "No difference data found for GM2\n";
+            std::cout << time_now() << "processRealTimeRGAData||" << "No new data found for GM1\n";
+            recordPendingFiles(pending_GM1, &polled_files);
+            current_RGA_data_GM1.clearData();
         }
-        if(!difference_RGA_data_Cluster.is_empty()) {
-            // Try to copy the data to influxDB with 100 retries
-            for(int i = 0; i < max_reconnect_attempts; ++i) {
-                try {    
-                    std::cout << time_now() << "processRealTimeRGAData||" << "Found difference data for Cluster... copying the following data into influxDB: \n";
-                    influx_db.copyRGADataToBucket(difference_RGA_data_Cluster, false);
-                    
-                    break;
-                    
-                } catch (std::exception& e) {
-                    std::cout << time_now() << "processRealTimeRGAData||" << "Error in copying Cluster data to influxDB: " << e.what() << "\n Retrying...\n";
-                    if (i == max_reconnect_attempts) {
-                        std::cout << time_now() << "processRealTimeRGAData||" << "Failed to copy Cluster data to influxDB after " << max_reconnect_attempts << " tries\n";
-                        exit(-1);
-                    }
-                                
-                    // Pause
-                    std::this_thread::sleep_for(std::chrono::seconds(sleep_seconds));
-
-                }
+        if(!new_RGA_data_GM2.is_empty()) {
+            std::cout << time_now() << "processRealTimeRGAData||" << "Found new data for GM2... copying the following data into influxDB: \n";
+            if (sendRealTime(influx_db, new_RGA_data_GM2, max_reconnect_attempts, sleep_seconds, "processRealTimeRGAData||", "GM2 RGA")) {
+                rga_delta_tracker.commit(new_RGA_data_GM2);
+                recordPendingFiles(pending_GM2, &polled_files);
+                current_RGA_data_GM2.clearData();
+            } else {
+                std::cout << time_now() << "processRealTimeRGAData||" << "Failed to copy GM2 RGA data to influxDB after " << max_reconnect_attempts << " tries, keeping it for the next poll\n";
             }
         } else {
-            std::cout << time_now() << "processRealTimeRGAData||" << "No difference data found for Cluster\n";
+            std::cout << time_now() << "processRealTimeRGAData||" << "No new data found for GM2\n";
+            recordPendingFiles(pending_GM2, &polled_files);
+            current_RGA_data_GM2.clearData();
         }
-
-        // Reset RGA data
-        previous_RGA_data_GM1 = current_RGA_data_GM1;
-        previous_RGA_data_GM2 = current_RGA_data_GM2;
-        previous_RGA_data_Cluster = current_RGA_data_Cluster;
-
-        current_RGA_data_GM1.clearData();
-        current_RGA_data_GM2.clearData();
-        current_RGA_data_Cluster.clearData();
-
-        // Flush all data from RGA data object if hour has changed
-        now = std::chrono::system_clock::now();
-        now_time = std::chrono::system_clock::to_time_t(now);
-        now_tm = std::localtime(&now_time);
-        if (now_tm->tm_hour != hour) {
-            previous_RGA_data_GM1.clearData();
-            previous_RGA_data_GM2.clearData();
-            previous_RGA_data_Cluster.clearData();
+        if(!new_RGA_data_Cluster.is_empty()) {
+            std::cout << time_now() << "processRealTimeRGAData||" << "Found new data for Cluster... copying the following data into influxDB: \n";
+            if (sendRealTime(influx_db, new_RGA_data_Cluster, max_reconnect_attempts, sleep_seconds, "processRealTimeRGAData||", "Cluster RGA")) {
+                rga_delta_tracker.commit(new_RGA_data_Cluster);
+                recordPendingFiles(pending_Cluster, &polled_files);
+                current_RGA_data_Cluster.clearData();
+            } else {
+                std::cout << time_now() << "processRealTimeRGAData||" << "Failed to copy Cluster RGA data to influxDB after " << max_reconnect_attempts << " tries, keeping it for the next poll\n";
+            }
+        } else {
+            std::cout << time_now() << "processRealTimeRGAData||" << "No new data found for Cluster\n";
+            recordPendingFiles(pending_Cluster, &polled_files);
+            current_RGA_data_Cluster.clearData();
         }
 
         std::cout << time_now() << "processRealTimeRGAData||" << "Sleeping for " << sleep_seconds << " seconds...\n";
@@ -399,28 +502,62 @@ void processHistoricalRGAData(std::promise<void> exitSignal) {
 
         // Check the health of the connection
         influx_db.checkConnection(true);
+        configureInfluxWrites(influx_db, batchPolicyFromConfig("INFLUX_BACKFILL_BATCH", BatchPolicy::backfill()), "rga_backfill", Priority::Backfill);
+
+        // Only the daily logs that exist, from the index of the RGA tree
+        FileIndex rga_index(FileIndex::Layout::RGA, config.getServerRGADataDir(), config.getRGAIndexFile());
+        rga_index.refresh();
+        std::cout << time_now() << "processHistoricalRGAData|| " << "Indexed " << rga_index.size() << " RGA data files\n";
 
         // Set integration limits and construct RGAData objects (e.g. integration_count = 4 => {+/-0.4}*Integer)
         const int& integration_count = 4;
-        RGAData GM1_rga_data(integration_count), 
-        GM2_rga_data(integration_count),
-        Cluster_rga_data(integration_count);
-
-        for(int year = 2025; year > 2020; --year){
-        for(int month = 12; month > 0; --month) {
-        for(int day = 31; day > 0; --day) {
-            const auto copy_result_GM1 = copyRGADataToInflux(influx_db, GM1_rga_data, "GM1", year, month, day);
-            const auto copy_result_GM2 = copyRGADataToInflux(influx_db, GM2_rga_data, "GM2", year, month, day);
-            const auto copy_result_Cluster = copyRGADataToInflux(influx_db, Cluster_rga_data, "Cluster", year, month, day);
-            if (copy_result_GM1 < 0 || copy_result_GM2 < 0 || copy_result_Cluster < 0)
-            {
-                std::cout << time_now() << "processHistoricalRGAData|| " << "Error in copying data to influxDB\n";
-                exit(-1);
+        std::map<std::string, RGAData> rga_data;
+        std::map<std::string, Batcher> accumulators;
+        std::map<std::string, std::vector<PendingFile>> pending;
+        for (const std::string GM : {"GM1", "GM2", "Cluster"}) {
+            rga_data.try_emplace(GM, integration_count);
+            accumulators.try_emplace(GM, backfillFlushPolicy());
+        }
+
+        // This thread parses; full accumulators are encoded and sent by the pipeline threads
+        CopyPipeline<RGAData> pipeline(influx_db, config.getEncoderWorkers(), config.getSenderWorkers(),
+            static_cast<std::size_t>(config.getPipelineQueueDepth()));
+
+        for (const IndexedFile& file : rga_index.files()) {
+            if (!rga_data.count(file.GM)) {
+                continue;
+            }
+
+            // Logs an earlier run loaded are skipped, grown ones only send their new samples
+            PendingFile ingested{file.path, LedgerEntry()};
+            const IngestLedger::Plan plan = IngestLedger::instance().plan(file.path, ingested.observed);
+            if (plan == IngestLedger::Plan::Skip) {
+                std::cout << time_now() << "processHistoricalRGAData|| " << "Already ingested " + file.GM + " RGA data file for: " << file.year << "," << file.month << "," << file.day << "\n";
+                continue;
+            }
+            RGAData file_data(integration_count);
+            if (!parseRGAFile(file, file_data)) {
+                continue;
             }
+            const double sent = ingested.observed.watermark;
+            ingested.observed.watermark = std::max(sent, IngestLedger::watermarkOf(file_data));
+            if (plan == IngestLedger::Plan::Resume) {
+                file_data.dropThrough(sent);
+            }
+            ingested.observed.points += file_data.getSampleCount();
+            rga_data.at(file.GM).append(file_data);
+            pending[file.GM].push_back(std::move(ingested));
+
+            copyToPipeline(pipeline, rga_data.at(file.GM), accumulators.at(file.GM), pending[file.GM], file.GM, false);
             std::cout << "--------------------------------------------\n";
         }
+
+        // Copy what is left of each GM and wait for the pipeline to send it
+        for (auto& [GM, files] : pending) {
+            copyToPipeline(pipeline, rga_data.at(GM), accumulators.at(GM), files, GM, true);
         }
-        }
+        pipeline.finish();
+        std::cout << time_now() << "processHistoricalRGAData|| " << "Sent " << pipeline.sentPoints() << " RGA samples\n";
         
         exitSignal.set_value();
 
@@ -442,25 +579,123 @@ void processHistoricalEpitrendData(std::promise<void> exitSignal) {
 
         // Check the health of the connection
         influx_db.checkConnection(true);
+        configureInfluxWrites(influx_db, batchPolicyFromConfig("INFLUX_BACKFILL_BATCH", BatchPolicy::backfill()), "epitrend_backfill", Priority::Backfill);
+
+        // Every (GM, hour) file is a task on a work-stealing pool, so the files are read from
+        // the share in parallel. Parsed files come back through a bounded queue, which holds
+        // the readers back while this thread merges them or the pipeline is behind.
+        const std::vector<std::string> GMs = {"GM1", "GM2"};
+        BoundedQueue<std::unique_ptr<EpitrendFile>> parsed_files(static_cast<std::size_t>(config.getBackfillQueueDepth()));
+        std::atomic<bool> cancelled{false};
+        // Only the hour files that exist, from the index of the Epitrend tree
+        FileIndex epitrend_index(FileIndex::Layout::Epitrend, config.getServerEpitrendDataDir(), config.getEpitrendIndexFile());
+        epitrend_index.refresh();
+        std::cout << time_now() << "processHistoricalEpitrendData|| " << "Indexed " << epitrend_index.size() << " Epitrend data files\n";
+
+        // Accumulate the parsed files per GM; full accumulators are encoded and sent by the
+        // pipeline threads while the readers go on. Set up before the reader thread starts,
+        // so a bad setting throws while there is no thread to join yet.
+        CopyPipeline<EpitrendBinaryData> pipeline(influx_db, config.getEncoderWorkers(), config.getSenderWorkers(),
+            static_cast<std::size_t>(config.getPipelineQueueDepth()));
+        std::map<std::string, EpitrendBinaryData> binary_data;
+        std::map<std::string, Batcher> accumulators;
+        std::map<std::string, std::vector<PendingFile>> pending;
+        for (const std::string& GM : GMs) {
+            accumulators.try_emplace(GM, backfillFlushPolicy());
+        }
 
-        EpitrendBinaryData binary_data_GM1, binary_data_GM2;
-        for(int year = 2025; year > 2019; --year){
-        for(int month = 12; month > 0; --month) {
-        for(int day = 31; day > 1; --day) {
-        for(int hour = 24; hour > -1; --hour) {
-            std::cout << time_now() << "Processing data for: " << year << "," << month << "," << day << "," << hour << "\n";
-            
-            const auto copy_result_GM1 = copyEpitrendDataToInflux(influx_db, binary_data_GM1, "GM1", year, month, day, hour);
-            const auto copy_result_GM2 = copyEpitrendDataToInflux(influx_db, binary_data_GM2, "GM2", year, month, day, hour);
-            if (copy_result_GM1 < 0 || copy_result_GM2 < 0)
-            {
-                std::cout << time_now() << "Error in copying data to influxDB\n";
-                exit(-1);
+        std::thread reader([&] {
+            // Files the ledger has with their indexed size and mtime are left out before any read
+            std::vector<IndexedFile> upcoming;
+            std::vector<std::string> upcoming_paths;
+            for (const IndexedFile& indexed : epitrend_index.files()) {
+                if (std::find(GMs.begin(), GMs.end(), indexed.GM) == GMs.end()) {
+                    continue;
+                }
+                if (IngestLedger::instance().unchanged(indexed.path, indexed.size, indexed.mtime)) {
+                    std::cout << time_now() << "Already ingested " + indexed.GM + " Epitrend data file for: " << indexed.year << "," << indexed.month << "," << indexed.day << "," << indexed.hour << "\n";
+                    continue;
+                }
+                upcoming_paths.push_back(FileReader::serverEpitrendBinaryFormatPath(config, indexed.GM, indexed.year, indexed.month, indexed.day, indexed.hour));
+                upcoming_paths.push_back(FileReader::serverEpitrendBinaryDataPath(config, indexed.GM, indexed.year, indexed.month, indexed.day, indexed.hour));
+                upcoming.push_back(indexed);
             }
+
+            // The loader reads the files in task order ahead of the workers, so a worker finds
+            // the bytes of its hour in memory instead of waiting on the share
+            FileLoader loader(std::move(upcoming_paths), config.getReadAheadThreads(),
+                static_cast<std::size_t>(config.getReadAheadFiles()));
+            WorkStealingPool pool(config.getBackfillWorkers());
+            for (const IndexedFile& indexed : upcoming) {
+                pool.submit([&parsed_files, &cancelled, &loader, indexed] {
+                    if (cancelled) {
+                        return;
+                    }
+                    // Files an earlier run loaded are skipped, grown ones only send their new samples
+                    auto file = std::make_unique<EpitrendFile>();
+                    file->ingested.path = indexed.path;
+                    const IngestLedger::Plan plan = IngestLedger::instance().plan(indexed.path, file->ingested.observed);
+                    if (plan == IngestLedger::Plan::Skip) {
+                        std::cout << time_now() << "Already ingested " + indexed.GM + " Epitrend data file for: " << indexed.year << "," << indexed.month << "," << indexed.day << "," << indexed.hour << "\n";
+                        loader.discard(FileReader::serverEpitrendBinaryFormatPath(config, indexed.GM, indexed.year, indexed.month, indexed.day, indexed.hour));
+                        loader.discard(FileReader::serverEpitrendBinaryDataPath(config, indexed.GM, indexed.year, indexed.month, indexed.day, indexed.hour));
+                        return;
+                    }
+
+                    // Reads from the share give way to real-time polls too
+                    Scheduler::instance().yieldToRealTime();
+                    file->GM = indexed.GM;
+                    file->year = indexed.year;
+                    file->month = indexed.month;
+                    file->day = indexed.day;
+                    file->hour = indexed.hour;
+                    if (parseEpitrendFile(*file, loader)) {
+                        LedgerEntry& observed = file->ingested.observed;
+                        const double sent = observed.watermark;
+                        observed.watermark = std::max(sent, IngestLedger::watermarkOf(file->data));
+                        if (plan == IngestLedger::Plan::Resume) {
+                            file->data.dropThrough(sent);
+                        }
+                        observed.points += file->data.getSampleCount();
+                        parsed_files.push(std::move(file));
+                    }
+                });
+            }
+            pool.wait();
+            std::cout << time_now() << "processHistoricalEpitrendData|| " << "Read all files, " << pool.stolenCount() << " tasks stolen, "
+                      << loader.readAhead() << " files read ahead, " << loader.readOnDemand() << " read on demand\n";
+            parsed_files.close();
+        });
+
+        // The readers stop when the copies fail, so the reader thread is always joined
+        auto stop_reader = [&] {
+            cancelled = true;
+            parsed_files.close();
+            reader.join();
+        };
+        std::unique_ptr<EpitrendFile> file;
+        try {
+        while (parsed_files.pop(file)) {
+            std::cout << time_now() << "Processing data for: " << file->year << "," << file->month << "," << file->day << "," << file->hour << "\n";
+            const std::string GM = file->GM;
+            binary_data[GM].append(file->data);
+            pending[GM].push_back(std::move(file->ingested));
+            file.reset();
+
+            copyToPipeline(pipeline, binary_data[GM], accumulators.at(GM), pending[GM], GM, false);
         }
+        } catch (...) {
+            stop_reader();
+            throw;
         }
+        reader.join();
+
+        // Copy what is left of each GM and wait for the pipeline to send it
+        for (const std::string& GM : GMs) {
+            copyToPipeline(pipeline, binary_data[GM], accumulators.at(GM), pending[GM], GM, true);
         }
-        }
+        pipeline.finish();
+        std::cout << time_now() << "processHistoricalEpitrendData|| " << "Sent " << pipeline.sentPoints() << " Epitrend samples\n";
         
         exitSignal.set_value();
 
@@ -486,13 +721,22 @@ void processRealTimeEpitrendData(std::promise<void> exitSignal) {
 
         // Check the health of the connection
         influx_db.checkConnection(true);
+        configureInfluxWrites(influx_db, batchPolicyFromConfig("INFLUX_REALTIME_BATCH", BatchPolicy::realTime()), "epitrend_realtime", Priority::RealTime);
 
-        // Update the database real-time - every second
-        EpitrendBinaryData previous_binary_data_GM1, previous_binary_data_GM2,
-        current_binary_data_GM1, current_binary_data_GM2,
-        difference_binary_data_GM1, difference_binary_data_GM2;
+        // Update the database real-time - every sleep_seconds
+        // Only samples newer than each sensor's watermark are decoded and sent
+        EpitrendBinaryData current_binary_data_GM1, current_binary_data_GM2;
+        EpitrendWatermarks watermarks_GM1, watermarks_GM2;
+
+        // Hour files in the ledger: a restart resumes after what the last run sent
+        std::map<std::string, PolledFile> polled_files;
 
         while (true) {
+        // Reading the hour files runs as a real-time job on the scheduler, ahead of any backfill;
+        // the sends below wait for the server on this thread
+        std::vector<PendingFile> pending_GM1, pending_GM2;
+        bool parsed = false;
+        Scheduler::instance().run(Priority::RealTime, [&] {
         std::cout << time_now() << "processRealTimeEpitrendData|| " << "Updating database in real-time...\n";
 
         // Grab the current year, month, day, and hour
@@ -506,84 +750,42 @@ void processRealTimeEpitrendData(std::promise<void> exitSignal) {
 
         std::cout << time_now() << "processRealTimeEpitrendData|| " << "Processing data for: " << year << "," << month << "," << day << "," << hour << "\n";
 
-        // Load the epitrend binary data into binary object
+        // Load the new epitrend binary data into binary object
+        current_binary_data_GM1.clear();
+        current_binary_data_GM2.clear();
         try {
-            FileReader::parseServerEpitrendBinaryDataFile(config, current_binary_data_GM1, "GM1", year, month, day, hour, false);
-            FileReader::parseServerEpitrendBinaryDataFile(config, current_binary_data_GM2, "GM2", year, month, day, hour, false);
+            FileReader::parseServerEpitrendBinaryDataFile(config, current_binary_data_GM1, "GM1", year, month, day, hour, watermarks_GM1, false);
+            FileReader::parseServerEpitrendBinaryDataFile(config, current_binary_data_GM2, "GM2", year, month, day, hour, watermarks_GM2, false);
         } catch (std::exception& e) {
             std::cout << time_now() << "processRealTimeEpitrendData|| " << "No epitrend data file found for: " << year << "," << month << "," << day << "," << hour << "\n" << e.what() << "\n";
-            std::this_thread::sleep_for(std::chrono::seconds(sleep_seconds));
-            continue;
+            return;
         }
-
-        // Find the difference between the previous and current data
-        difference_binary_data_GM1 = current_binary_data_GM1.difference(previous_binary_data_GM1);
-        difference_binary_data_GM2 = current_binary_data_GM2.difference(previous_binary_data_GM2);
-
-        // Copy the difference data to the influxDB
-        if(!difference_binary_data_GM1.is_empty()) {
-            // Try to copy the data to influxDB with max_reconnect_attempts retries
-            for(int i = 0; i < max_reconnect_attempts; ++i) {
-                try {    
-                    std::cout << time_now() << "processRealTimeEpitrendData|| " << "Found difference data for GM1... copying the following data into influxDB: \n";
-                    // difference_binary_data_GM1.printAllTimeSeriesData();
-                    
-                    influx_db.copyEpitrendToBucket2(difference_binary_data_GM1, false);
-                    
-                    break;  
-                
-                } catch (std::exception& e) {
-                    std::cout << time_now() << "processRealTimeEpitrendData|| " << "Error in copying GM1 data to influxDB: " << e.what() << "\n Retrying...\n";
-                    if (i == max_reconnect_attempts) {
-                        std::cout << time_now() << "processRealTimeEpitrendData|| " << "Failed to copy GM1 data to influxDB after " << max_reconnect_attempts << " tries\n";
-                        exit(-1);
-                    }
-                                
-                    // Pause
-                    std::this_thread::sleep_for(std::chrono::seconds(sleep_seconds));
-
-                }
+        resumeFromLedger(FileReader::serverEpitrendBinaryDataPath(config, "GM1", year, month, day, hour), current_binary_data_GM1, polled_files, pending_GM1);
+        resumeFromLedger(FileReader::serverEpitrendBinaryDataPath(config, "GM2", year, month, day, hour), current_binary_data_GM2, polled_files, pending_GM2);
+
+        parsed = true;
+        });
+
+        // Copy the new data to the influxDB
+        if(parsed && !current_binary_data_GM1.is_empty()) {
+            std::cout << time_now() << "processRealTimeEpitrendData|| " << "Found new data for GM1... copying the following data into influxDB: \n";
+            // current_binary_data_GM1.printAllTimeSeriesData();
+            if (!sendRealTime(influx_db, current_binary_data_GM1, max_reconnect_attempts, sleep_seconds, "processRealTimeEpitrendData|| ", "GM1")) {
+                std::cout << time_now() << "processRealTimeEpitrendData|| " << "Failed to copy GM1 data to influxDB after " << max_reconnect_attempts << " tries\n";
+                exit(-1);
             }
+            FileReader::commitEpitrendWatermarks(current_binary_data_GM1, watermarks_GM1);
+            recordPendingFiles(pending_GM1, &polled_files);
         }
-        if(!difference_binary_data_GM2.is_empty()) {
-            // Try to copy the data to influxDB with 100 retries
-            for(int i = 0; i < max_reconnect_attempts; ++i) {
-                try {    
-                    std::cout << time_now() << "processRealTimeEpitrendData|| " << "Found difference data for GM2... copying the following data into influxDB: \n";
-                    // difference_binary_data_GM2.printAllTimeSeriesData();
-
-                    influx_db.copyEpitrendToBucket2(difference_binary_data_GM2, false);
-                    
-                    break;
-                    
-                } catch (std::exception& e) {
-                    std::cout << time_now() << "processRealTimeEpitrendData|| " << "Error in copying GM2 data to influxDB: " << e.what() << "\n Retrying...\n";
-                    if (i == max_reconnect_attempts) {
-                        std::cout << time_now() << "processRealTimeEpitrendData|| " << "Failed to copy GM2 data to influxDB after " << max_reconnect_attempts << " tries\n";
-                        exit(-1);
-                    }
-                                
-                    // Pause
-                    std::this_thread::sleep_for(std::chrono::seconds(sleep_seconds));
-
-                }
+        if(parsed && !current_binary_data_GM2.is_empty()) {
+            std::cout << time_now() << "processRealTimeEpitrendData|| " << "Found new data for GM2... copying the following data into influxDB: \n";
+            // current_binary_data_GM2.printAllTimeSeriesData();
+            if (!sendRealTime(influx_db, current_binary_data_GM2, max_reconnect_attempts, sleep_seconds, "processRealTimeEpitrendData|| ", "GM2")) {
+                std::cout << time_now() << "processRealTimeEpitrendData|| " << "Failed to copy GM2 data to influxDB after " << max_reconnect_attempts << " tries\n";
+                exit(-1);
             }
-        }
-
-        // Reset binary data
-        previous_binary_data_GM1 = current_binary_data_GM1;
-        previous_binary_data_GM2 = current_binary_data_GM2;
-
-        current_binary_data_GM1.clear();
-        current_binary_data_GM2.clear();
-
-        // Flush all data from epitrend binary data object if hour has changed
-        now = std::chrono::system_clock::now();
-        now_time = std::chrono::system_clock::to_time_t(now);
-        now_tm = std::localtime(&now_time);
-        if (now_tm->tm_hour != hour) {
-            previous_binary_data_GM1.clear();
-            previous_binary_data_GM2.clear();
+            FileReader::commitEpitrendWatermarks(current_binary_data_GM2, watermarks_GM2);
+            recordPendingFiles(pending_GM2, &polled_files);
         }
 
         std::this_thread::sleep_for(std::chrono::seconds(sleep_seconds));
@@ -614,6 +816,22 @@ int main() {
     std::cout << "precision: " << precision << "\n";
     std::cout << "token: " << token << "\n";
 
+    // Load the sensor ids cached by earlier runs, shared by all threads
+    SensorRegistry::instance().open(config.getSensorRegistryFile());
+
+    // Lines InfluxDB refuses are kept here instead of failing their whole batch
+    RejectLog::instance().open(config.getRejectFile());
+
+    // Files loaded by earlier runs, so a restart skips or resumes them
+    IngestLedger::instance().open(config.getLedgerFile());
+
+    // All threads write through one sink, which merges their batches per bucket
+    SharedSink::instance().setPolicy(batchPolicyFromConfig("INFLUX_SINK_BATCH", BatchPolicy::coalesce()));
+
+    // The threads below only drive their loops; parsing and copying run as jobs on the
+    // scheduler's workers, real-time first, backfill within its share
+    Scheduler::instance().start(config.getSchedulerWorkers(), config.getBackfillShare());
+
     // Create promises and futures for each thread
     std::promise<void> promiseRealTimeRGA, promiseHistoricalRGA, promiseHistoricalEpitrend, promiseRealTimeEpitrend;
     std::future<void> futureRealTimeRGA = promiseRealTimeRGA.get_future();
@@ -629,7 +847,14 @@ int main() {
 
     // Monitor the futures to detect when threads have stopped running
     std::vector<std::future<void>*> futures = {&futureRealTimeRGA, &futureHistoricalRGA, &futureHistoricalEpitrend, &futureRealTimeEpitrend};
+    const auto report_interval = std::chrono::seconds(std::stoi(config.getValueOr("SCHEDULER_REPORT_SECONDS", "60")));
+    auto next_report = std::chrono::steady_clock::now() + report_interval;
     while (!futures.empty()) {
+        // Queue depth and wait times of each priority class
+        if (std::chrono::steady_clock::now() >= next_report) {
+            std::cout << time_now() << Scheduler::instance().report() << "\n";
+            next_report += report_interval;
+        }
         for (auto it = futures.begin(); it != futures.end();) {
             std::future_status status = (*it)->wait_for(std::chrono::milliseconds(100));
             if (status == std::future_status::ready) {